@@ -84,6 +84,8 @@
 #define MINI_INI_H_
 
 #include <string>
+#include <string_view>
+#include <functional>
 #include <sstream>
 #include <algorithm>
 #include <utility>
@@ -104,6 +106,16 @@ namespace mINI
 			str.erase(str.find_last_not_of(whitespaceDelimiters) + 1);
 			str.erase(0, str.find_first_not_of(whitespaceDelimiters));
 		}
+		inline std::string_view trimmed(std::string_view str)
+		{
+			const std::size_t first = str.find_first_not_of(whitespaceDelimiters);
+			if (first == std::string_view::npos)
+			{
+				return {};
+			}
+			const std::size_t last = str.find_last_not_of(whitespaceDelimiters);
+			return str.substr(first, last - first + 1);
+		}
 #ifndef MINI_CASE_SENSITIVE
 		inline void toLower(std::string& str)
 		{
@@ -111,7 +123,44 @@ namespace mINI
 				return static_cast<char>(std::tolower(c));
 			});
 		}
+		inline char lowerChar(const char c)
+		{
+			return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+		}
+#endif
+		// transparent hash and equality so keys can be looked up by
+		// string_view without building (and lowering) a temporary string
+		struct KeyHash
+		{
+			using is_transparent = void;
+			std::size_t operator()(std::string_view str) const noexcept
+			{
+#ifdef MINI_CASE_SENSITIVE
+				return std::hash<std::string_view>{}(str);
+#else
+				std::size_t hash = static_cast<std::size_t>(2166136261u);
+				for (const char c : str)
+				{
+					hash = (hash ^ static_cast<unsigned char>(lowerChar(c))) * static_cast<std::size_t>(16777619u);
+				}
+				return hash;
+#endif
+			}
+		};
+		struct KeyEqual
+		{
+			using is_transparent = void;
+			bool operator()(std::string_view a, std::string_view b) const noexcept
+			{
+#ifdef MINI_CASE_SENSITIVE
+				return a == b;
+#else
+				return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const char x, const char y) {
+					return lowerChar(x) == lowerChar(y);
+				});
 #endif
+			}
+		};
 		inline void replace(std::string& str, std::string const& a, std::string const& b)
 		{
 			if (!a.empty())
@@ -135,7 +184,7 @@ namespace mINI
 	class INIMap
 	{
 	private:
-		using T_DataIndexMap = std::unordered_map<std::string, std::size_t>;
+		using T_DataIndexMap = std::unordered_map<std::string, std::size_t, INIStringUtil::KeyHash, INIStringUtil::KeyEqual>;
 		using T_DataItem = std::pair<std::string, T>;
 		using T_DataContainer = std::vector<T_DataItem>;
 		using T_MultiArgs = typename std::vector<std::pair<std::string, T>>;
@@ -143,11 +192,21 @@ namespace mINI
 		T_DataIndexMap dataIndexMap;
 		T_DataContainer data;
 
-		std::size_t setEmpty(std::string& key)
+		static std::string makeKey(std::string_view key)
+		{
+			std::string result(key);
+#ifndef MINI_CASE_SENSITIVE
+			INIStringUtil::toLower(result);
+#endif
+			return result;
+		}
+
+		std::size_t setEmpty(std::string_view key)
 		{
 			const std::size_t index = data.size();
-			dataIndexMap[key] = index;
-			data.emplace_back(key, T());
+			std::string newKey = makeKey(key);
+			dataIndexMap[newKey] = index;
+			data.emplace_back(std::move(newKey), T());
 			return index;
 		}
 
@@ -160,23 +219,17 @@ namespace mINI
 		{
 		}
 
-		T& operator[](std::string key)
+		T& operator[](std::string_view key)
 		{
-			INIStringUtil::trim(key);
-#ifndef MINI_CASE_SENSITIVE
-			INIStringUtil::toLower(key);
-#endif
+			key = INIStringUtil::trimmed(key);
 			auto it = dataIndexMap.find(key);
 			const bool hasIt = (it != dataIndexMap.end());
 			const std::size_t index = (hasIt) ? it->second : setEmpty(key);
 			return data[index].second;
 		}
-		[[nodiscard]] T get(std::string key) const
+		[[nodiscard]] T get(std::string_view key) const
 		{
-			INIStringUtil::trim(key);
-#ifndef MINI_CASE_SENSITIVE
-			INIStringUtil::toLower(key);
-#endif
+			key = INIStringUtil::trimmed(key);
 			auto it = dataIndexMap.find(key);
 			if (it == dataIndexMap.end())
 			{
@@ -184,20 +237,14 @@ namespace mINI
 			}
 			return T(data[it->second].second);
 		}
-		[[nodiscard]] bool has(std::string key) const
+		[[nodiscard]] bool has(std::string_view key) const
 		{
-			INIStringUtil::trim(key);
-#ifndef MINI_CASE_SENSITIVE
-			INIStringUtil::toLower(key);
-#endif
-			return (dataIndexMap.count(key) == 1);
+			key = INIStringUtil::trimmed(key);
+			return (dataIndexMap.find(key) != dataIndexMap.end());
 		}
-		void set(std::string key, T obj)
+		void set(std::string_view key, T obj)
 		{
-			INIStringUtil::trim(key);
-#ifndef MINI_CASE_SENSITIVE
-			INIStringUtil::toLower(key);
-#endif
+			key = INIStringUtil::trimmed(key);
 			auto it = dataIndexMap.find(key);
 			if (it != dataIndexMap.end())
 			{
@@ -205,8 +252,9 @@ namespace mINI
 			}
 			else
 			{
-				dataIndexMap[key] = data.size();
-				data.emplace_back(key, obj);
+				std::string newKey = makeKey(key);
+				dataIndexMap[newKey] = data.size();
+				data.emplace_back(std::move(newKey), obj);
 			}
 		}
 		void set(T_MultiArgs const& multiArgs)
@@ -218,12 +266,9 @@ namespace mINI
 				set(key, obj);
 			}
 		}
-		bool remove(std::string key)
+		bool remove(std::string_view key)
 		{
-			INIStringUtil::trim(key);
-#ifndef MINI_CASE_SENSITIVE
-			INIStringUtil::toLower(key);
-#endif
+			key = INIStringUtil::trimmed(key);
 			auto it = dataIndexMap.find(key);
 			if (it != dataIndexMap.end())
 			{
@@ -3,11 +3,15 @@
 
 #include <Windows.h>
 
+#include <atomic>
 #include <stacktrace>
+#include <variant>
 
 #include "ini.hpp"
 #include "dllmain.hpp"
 #include "helper.hpp"
+#include "framelimiter.hpp"
+#include "frametelemetry.hpp"
 #include <shlwapi.h>
 #pragma comment(lib, "shlwapi.lib")
 
@@ -24,9 +28,8 @@ struct GlobalState
 	float scaleFactor = 0.0f;
 
 	// Physics
-	float frameTimeScale = 0.0f;
-	float savedClothDeltaTime = 0.0f;
-	float savedHairDeltaTime = 0.0f;
+	float physicsStep = 0.0f;
+	float physicsUpdateInterval = 0.0f;
 
 	// FOV
 	DWORD pFOV = 0;
@@ -40,9 +43,16 @@ struct GlobalState
 	DWORD pInput = 0;
 	bool isUsingGamepad = false;
 
+	// Frame rate
+	float targetFPS = 0.0f;
+	HWND gameWindow = NULL;
+	HMONITOR gameMonitor = NULL;
+	ULONGLONG lastMonitorCheck = 0;
+	bool refreshRateChanged = false;
+
 	// Misc
-	bool set40fps = false;
-	bool prev_set40fps = false;
+	bool isLoading = false;
+	bool prev_isLoading = false;
 	float original_fps = 0.0f;
 	bool shouldSkipMovie = false;
 };
@@ -51,7 +61,6 @@ struct GlobalState
 GlobalState g_State;
 
 // Ini Settings override
-static std::vector<std::unique_ptr<wchar_t[]>> g_tempConfigStrings;
 static const wchar_t* g_replacementString = nullptr;
 
 // Ini Input override
@@ -65,9 +74,17 @@ struct PendingRestore
 };
 
 static PendingRestore g_pendingRestore = { 0, nullptr, 0, 0, false };
-static std::vector<std::unique_ptr<wchar_t[]>> g_tempFixedStrings;
+
+// Rewritten binding, only needs to live until the engine has copied it
+static MemoryHelper::BumpArena g_inputBindingArena(0x100000);
+static wchar_t* g_bindingBuffer = nullptr;
+static size_t g_bindingBufferLength = 0;
 
 static constexpr float TARGET_FRAME_TIME = 1.0f / 30.0f;
+static constexpr int MAX_FPS_MATCH_REFRESH = -1;
+static constexpr ULONGLONG MONITOR_CHECK_INTERVAL_MS = 500;
+static constexpr DWORD BACKGROUND_IDLE_SLICE_MS = 10;
+static constexpr ULONGLONG BACKGROUND_IDLE_MAX_MS = 250;
 static constexpr float ASPECT_RATIO_16_9 = 16.0f / 9.0f;
 
 // =============================
@@ -77,9 +94,16 @@ static constexpr float ASPECT_RATIO_16_9 = 16.0f / 9.0f;
 // Fixes
 bool FixHighFPSHairPhysics = false;
 bool FixHighFPSClothPhysics = false;
+bool FixedPhysicsTimestep = false;
+int PhysicsStepRate = 0;
+bool LowRatePhysics = false;
+int PhysicsUpdateRate = 0;
 bool FixHighFPSProjectileCollisionCheck = false;
 bool FixHighFPSRagdollDeath = false;
 bool FixHashTableRaceCondition = false;
+bool AdaptiveLoadingFPS = false;
+int LoadingFPS = 0;
+int LoadingMaxFPS = 0;
 bool FixInputBinding = false;
 bool FixWindowHandling = false;
 
@@ -104,6 +128,10 @@ bool SkipCutscenesWithEnter = false;
 
 // Graphics
 int MaxFPS = 0;
+bool VRRFriendlyFPS = false;
+int BackgroundMaxFPS = 0;
+bool IdleInBackground = false;
+bool PreciseFrameLimiter = false;
 bool EnableMaxSmoothedFrameRate = false;
 bool ImprovedTextureStreaming = false;
 bool ForceHighResTextures = false;
@@ -111,394 +139,1605 @@ bool FixUltraWideScreenFOV = false;
 bool ReducedMipMapBias = false;
 bool FixBinkVideoBT709 = false;
 
+// Debug
+bool TraceConfigReads = false;
+bool RecordFrameStats = false;
+int FrameStatsKey = 0;
+bool ProfileLocalizeLock = false;
+
+// Benchmark
+bool RunBenchmark = false;
+std::string BenchmarkMap;
+int BenchmarkSeconds = 0;
+
+enum class BindingAction : uint8_t
+{
+	Replace,
+	Remove,
+	Prepend
+};
+
+struct BindingRule
+{
+	std::wstring_view name;
+	BindingAction action;
+	std::wstring_view command;
+	std::wstring_view replacement;
+	const bool* isEnabled;
+};
+
+static constexpr BindingRule BINDING_RULES[] =
+{
+	// Workaround for automatic movement
+	{L"MoveForward", BindingAction::Replace, L"Axis aBaseY Speed=1.0", L"Axis aBaseY Speed=1.0 | OnRelease Axis aBaseY Speed=0.0", nullptr},
+
+	// SkipCutscenesWithEnter
+	{L"SpaceBar", BindingAction::Remove, L"TryToCancelMatinee", {}, &SkipCutscenesWithEnter},
+	{L"Enter", BindingAction::Prepend, L"TryToCancelMatinee", {}, &SkipCutscenesWithEnter}
+};
+
+static constexpr size_t CONFIG_VALUE_LENGTH = 32;
+static constexpr size_t MAX_CONFIG_OVERRIDES = 64;
+static constexpr size_t CONFIG_INDEX_SLOTS = 1024;
+static constexpr uint8_t CONFIG_INDEX_EMPTY = 0xFF;
+
 struct ConfigOverride
 {
-	std::wstring value;
+	const wchar_t* section;
+	const wchar_t* key;
+	wchar_t value[CONFIG_VALUE_LENGTH];
 	bool* isEnabled;
 };
 
-static std::unordered_map<std::wstring, ConfigOverride> g_configOverrides = 
+static constexpr ConfigOverride CONFIG_OVERRIDE_DEFAULTS[] =
 {
 	// [Engine.Engine]
-	{L"MaxSmoothedFrameRate", {L"120", &EnableMaxSmoothedFrameRate}},
-	{L"MipLevelFadingInRate", {L"0.0", &ImprovedTextureStreaming}},
-	{L"MipLevelFadingOutRate", {L"0.0", &ImprovedTextureStreaming}},
+	{L"Engine.Engine", L"MaxSmoothedFrameRate", L"120", &EnableMaxSmoothedFrameRate},
+	{L"Engine.Engine", L"MipLevelFadingInRate", L"0.0", &ImprovedTextureStreaming},
+	{L"Engine.Engine", L"MipLevelFadingOutRate", L"0.0", &ImprovedTextureStreaming},
 
 	// [Engine.ISVHacks]
-	{L"DisableATITextureFilterOptimizationChecks", {L"False", &DisableLegacyDriverHacks}},
-	{L"UseMinimalNVIDIADriverShaderOptimization", {L"False", &DisableLegacyDriverHacks}},
+	{L"Engine.ISVHacks", L"DisableATITextureFilterOptimizationChecks", L"False", &DisableLegacyDriverHacks},
+	{L"Engine.ISVHacks", L"UseMinimalNVIDIADriverShaderOptimization", L"False", &DisableLegacyDriverHacks},
 
 	// [TextureStreaming]
-	{L"MinTimeToGuaranteeMinMipCount", {L"0", &ImprovedTextureStreaming}},
-	{L"MaxTimeToGuaranteeMinMipCount", {L"0", &ImprovedTextureStreaming}},
-	{L"HysteresisLimit", {L"30", &ImprovedTextureStreaming}},
-	{L"DropMipLevelsLimit", {L"20", &ImprovedTextureStreaming}},
-	{L"StopIncreasingLimit", {L"20", &ImprovedTextureStreaming}},
-	{L"StopStreamingLimit", {L"12", &ImprovedTextureStreaming}},
-	{L"MinEvictSize", {L"10", &ImprovedTextureStreaming}},
-	{L"MipLevelFadingInRate", {L"0.0", &ImprovedTextureStreaming}},
-	{L"MipLevelFadingOutRate", {L"0.0", &ImprovedTextureStreaming}},
+	{L"TextureStreaming", L"MinTimeToGuaranteeMinMipCount", L"0", &ImprovedTextureStreaming},
+	{L"TextureStreaming", L"MaxTimeToGuaranteeMinMipCount", L"0", &ImprovedTextureStreaming},
+	{L"TextureStreaming", L"HysteresisLimit", L"30", &ImprovedTextureStreaming},
+	{L"TextureStreaming", L"DropMipLevelsLimit", L"20", &ImprovedTextureStreaming},
+	{L"TextureStreaming", L"StopIncreasingLimit", L"20", &ImprovedTextureStreaming},
+	{L"TextureStreaming", L"StopStreamingLimit", L"12", &ImprovedTextureStreaming},
+	{L"TextureStreaming", L"MinEvictSize", L"10", &ImprovedTextureStreaming},
+	{L"TextureStreaming", L"MipLevelFadingInRate", L"0.0", &ImprovedTextureStreaming},
+	{L"TextureStreaming", L"MipLevelFadingOutRate", L"0.0", &ImprovedTextureStreaming},
 
 	// [SystemSettings]
-	{L"Fullscreen", {L"False", &UseWindowed}},
+	{L"SystemSettings", L"Fullscreen", L"False", &UseWindowed},
 
 	// [AliceGame.AliceGameEngine]
-	{L"GIsSpecialPCEdition", {L"True", &UnlockCompleteEditionDLC}},
+	{L"AliceGame.AliceGameEngine", L"GIsSpecialPCEdition", L"True", &UnlockCompleteEditionDLC},
 
 	// [Engine.PlayerInput]
-	{L"bEnableMouseSmoothing", {L"False", &DisableMouseSmoothing}}
+	{L"Engine.PlayerInput", L"bEnableMouseSmoothing", L"False", &DisableMouseSmoothing}
+};
+
+static constexpr std::array<ConfigOverride, MAX_CONFIG_OVERRIDES> MakeConfigOverrideTable()
+{
+	std::array<ConfigOverride, MAX_CONFIG_OVERRIDES> table{};
+	std::copy(std::begin(CONFIG_OVERRIDE_DEFAULTS), std::end(CONFIG_OVERRIDE_DEFAULTS), table.begin());
+	return table;
+}
+
+// Values are rewritten by ReadConfig and [EngineOverrides.*] entries are appended, the hook hands out pointers into this table
+constinit static auto g_configOverrides = MakeConfigOverrideTable();
+static size_t g_configOverrideCount = std::size(CONFIG_OVERRIDE_DEFAULTS);
+
+// Section and key names of [EngineOverrides.*] entries, kept for the lifetime of the process since the override table and index point into it
+static MemoryHelper::BumpArena g_configArena(0x100000);
+static bool g_userConfigOverrideEnabled = true;
+
+struct ConfigOverrideIndex
+{
+	uint32_t seed = 0;
+	bool isValid = false;
+	std::array<uint8_t, CONFIG_INDEX_SLOTS> slots{};
+};
+
+static constexpr wchar_t ToLowerAscii(wchar_t c)
+{
+	return (c >= L'A' && c <= L'Z') ? static_cast<wchar_t>(c + (L'a' - L'A')) : c;
+}
+
+// FNV-1a over section and key, case-insensitive like the engine's own config lookups
+static constexpr uint64_t HashConfigKey(const wchar_t* section, const wchar_t* key)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (; *section; ++section)
+	{
+		hash = (hash ^ ToLowerAscii(*section)) * 1099511628211ULL;
+	}
+
+	hash = (hash ^ L'|') * 1099511628211ULL;
+	for (; *key; ++key)
+	{
+		hash = (hash ^ ToLowerAscii(*key)) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+static constexpr uint32_t GetConfigSlot(uint64_t hash, uint32_t seed)
+{
+	hash ^= seed * 0x9E3779B97F4A7C15ULL;
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDULL;
+	hash ^= hash >> 33;
+	return static_cast<uint32_t>(hash) & (CONFIG_INDEX_SLOTS - 1);
+}
+
+// Searches for a seed that gives every entry its own slot, so a lookup is one hash and one compare
+static constexpr ConfigOverrideIndex BuildConfigOverrideIndex(std::span<const ConfigOverride> overrides)
+{
+	ConfigOverrideIndex index;
+	if (overrides.size() > MAX_CONFIG_OVERRIDES)
+		return index;
+
+	std::array<uint64_t, MAX_CONFIG_OVERRIDES> hashes{};
+	for (size_t i = 0; i < overrides.size(); i++)
+	{
+		hashes[i] = HashConfigKey(overrides[i].section, overrides[i].key);
+	}
+
+	for (uint32_t seed = 0; seed < 0x10000; seed++)
+	{
+		index.slots.fill(CONFIG_INDEX_EMPTY);
+		index.isValid = true;
+
+		for (size_t i = 0; i < overrides.size() && index.isValid; i++)
+		{
+			uint8_t& slot = index.slots[GetConfigSlot(hashes[i], seed)];
+			index.isValid = slot == CONFIG_INDEX_EMPTY;
+			slot = static_cast<uint8_t>(i);
+		}
+
+		if (index.isValid)
+		{
+			index.seed = seed;
+			return index;
+		}
+	}
+
+	return index;
+}
+
+static_assert(MAX_CONFIG_OVERRIDES < CONFIG_INDEX_EMPTY);
+static_assert(BuildConfigOverrideIndex(CONFIG_OVERRIDE_DEFAULTS).isValid, "Config overrides must have unique section/key pairs");
+
+// Rebuilt at runtime once the user overrides are loaded
+constinit static ConfigOverrideIndex g_configOverrideIndex = BuildConfigOverrideIndex(CONFIG_OVERRIDE_DEFAULTS);
+
+static ConfigOverride* FindConfigOverride(const wchar_t* section, const wchar_t* key)
+{
+	uint8_t slot = g_configOverrideIndex.slots[GetConfigSlot(HashConfigKey(section, key), g_configOverrideIndex.seed)];
+	if (slot == CONFIG_INDEX_EMPTY)
+		return nullptr;
+
+	ConfigOverride& entry = g_configOverrides[slot];
+	if (_wcsicmp(entry.key, key) != 0 || _wcsicmp(entry.section, section) != 0)
+		return nullptr;
+
+	return &entry;
+}
+
+static void UpdateConfigInt(const wchar_t* section, const wchar_t* key, int value)
+{
+	if (ConfigOverride* entry = FindConfigOverride(section, key))
+	{
+		swprintf_s(entry->value, L"%d", value);
+	}
+}
+
+static void UpdateConfigBool(const wchar_t* section, const wchar_t* key, bool value)
+{
+	if (ConfigOverride* entry = FindConfigOverride(section, key))
+	{
+		wcscpy_s(entry->value, value ? L"True" : L"False");
+	}
+}
+
+static constexpr std::string_view ENGINE_OVERRIDES_PREFIX = "EngineOverrides.";
+
+// Target and default of one setting, the value type follows from the target so they can't disagree
+template <typename T, typename Default = T>
+struct TypedSetting
+{
+	T* target;
+	Default defaultValue;
+};
+
+using ConfigValue = std::variant<TypedSetting<bool>, TypedSetting<int>, TypedSetting<float>, TypedSetting<std::string, std::string_view>>;
+
+struct ConfigSetting
+{
+	std::string_view section;
+	std::string_view key;
+	ConfigValue value;
+
+	constexpr ConfigSetting(std::string_view section, std::string_view key, bool* target, bool defaultValue)
+		: section(section), key(key), value(TypedSetting<bool>{ target, defaultValue }) {}
+	constexpr ConfigSetting(std::string_view section, std::string_view key, int* target, int defaultValue)
+		: section(section), key(key), value(TypedSetting<int>{ target, defaultValue }) {}
+	constexpr ConfigSetting(std::string_view section, std::string_view key, float* target, float defaultValue)
+		: section(section), key(key), value(TypedSetting<float>{ target, defaultValue }) {}
+	constexpr ConfigSetting(std::string_view section, std::string_view key, std::string* target, std::string_view defaultValue)
+		: section(section), key(key), value(TypedSetting<std::string, std::string_view>{ target, defaultValue }) {}
+};
+
+static constexpr ConfigSetting g_configSchema[] =
+{
+	// Fixes
+	{"Fixes", "FixHighFPSHairPhysics", &FixHighFPSHairPhysics, true},
+	{"Fixes", "FixHighFPSClothPhysics", &FixHighFPSClothPhysics, true},
+	{"Fixes", "FixedPhysicsTimestep", &FixedPhysicsTimestep, false},
+	{"Fixes", "PhysicsStepRate", &PhysicsStepRate, 30},
+	{"Fixes", "LowRatePhysics", &LowRatePhysics, false},
+	{"Fixes", "PhysicsUpdateRate", &PhysicsUpdateRate, 60},
+	{"Fixes", "FixHighFPSProjectileCollisionCheck", &FixHighFPSProjectileCollisionCheck, true},
+	{"Fixes", "FixHighFPSRagdollDeath", &FixHighFPSRagdollDeath, true},
+	{"Fixes", "FixHashTableRaceCondition", &FixHashTableRaceCondition, true},
+	{"Fixes", "AdaptiveLoadingFPS", &AdaptiveLoadingFPS, false},
+	{"Fixes", "LoadingFPS", &LoadingFPS, 40},
+	{"Fixes", "LoadingMaxFPS", &LoadingMaxFPS, 60},
+	{"Fixes", "FixInputBinding", &FixInputBinding, true},
+	{"Fixes", "FixWindowHandling", &FixWindowHandling, true},
+
+	// General
+	{"General", "UnlockCompleteEditionDLC", &UnlockCompleteEditionDLC, true},
+	{"General", "DisableLegacyDriverHacks", &DisableLegacyDriverHacks, true},
+	{"General", "CheckAlice1InstallFolder", &CheckAlice1InstallFolder, true},
+	{"General", "SkipEAIntro", &SkipEAIntro, false},
+	{"General", "SkipSHIntro", &SkipSHIntro, true},
+	{"General", "SkipUEIntro", &SkipUEIntro, true},
+
+	// Display
+	{"Display", "FontScaling", &FontScaling, true},
+	{"Display", "FontScalingFactor", &FontScalingFactor, 1.0f},
+	{"Display", "UseWindowed", &UseWindowed, false},
+
+	// Input
+	{"Input", "DisableMouseAcceleration", &DisableMouseAcceleration, true},
+	{"Input", "DisableControllerAcceleration", &DisableControllerAcceleration, false},
+	{"Input", "DisableMouseSmoothing", &DisableMouseSmoothing, false},
+	{"Input", "SkipCutscenesWithEnter", &SkipCutscenesWithEnter, false},
+
+	// Graphics
+	{"Graphics", "MaxFPS", &MaxFPS, 120},
+	{"Graphics", "VRRFriendlyFPS", &VRRFriendlyFPS, false},
+	{"Graphics", "BackgroundMaxFPS", &BackgroundMaxFPS, 0},
+	{"Graphics", "IdleInBackground", &IdleInBackground, false},
+	{"Graphics", "PreciseFrameLimiter", &PreciseFrameLimiter, false},
+	{"Graphics", "ForceHighResTextures", &ForceHighResTextures, true},
+	{"Graphics", "ImprovedTextureStreaming", &ImprovedTextureStreaming, true},
+	{"Graphics", "FixUltraWideScreenFOV", &FixUltraWideScreenFOV, true},
+	{"Graphics", "ReducedMipMapBias", &ReducedMipMapBias, true},
+	{"Graphics", "FixBinkVideoBT709", &FixBinkVideoBT709, true},
+
+	// Debug
+	{"Debug", "TraceConfigReads", &TraceConfigReads, false},
+	{"Debug", "RecordFrameStats", &RecordFrameStats, false},
+	{"Debug", "FrameStatsKey", &FrameStatsKey, VK_F11},
+	{"Debug", "ProfileLocalizeLock", &ProfileLocalizeLock, false},
+
+	// Benchmark
+	{"Benchmark", "RunBenchmark", &RunBenchmark, false},
+	{"Benchmark", "BenchmarkMap", &BenchmarkMap, ""},
+	{"Benchmark", "BenchmarkSeconds", &BenchmarkSeconds, 60}
+};
+
+struct ConfigIssue
+{
+	std::string_view section;
+	std::string_view key;
+	const char* reason;
+};
+
+struct ConfigReport
+{
+	std::array<ConfigIssue, 32> issues;
+	size_t count = 0;
+
+	void Add(std::string_view section, std::string_view key, const char* reason)
+	{
+		if (count < issues.size())
+		{
+			issues[count++] = { section, key, reason };
+		}
+	}
 };
 
-static void UpdateConfigInt(const wchar_t* key, int value)
+static const ConfigSetting* FindConfigSetting(std::string_view section, std::string_view key)
+{
+	for (const ConfigSetting& setting : g_configSchema)
+	{
+		if (setting.key == key && setting.section == section)
+			return &setting;
+	}
+	return nullptr;
+}
+
+static void ApplyConfigDefault(const ConfigSetting& setting)
+{
+	std::visit([](const auto& typed) { *typed.target = typed.defaultValue; }, setting.value);
+}
+
+static bool ParseConfigValue(std::string_view text, bool& target)
+{
+	int value = 0;
+	if (!IniHelper::ParseNumber(text, value))
+		return false;
+
+	target = value == 1;
+	return true;
+}
+
+static bool ParseConfigValue(std::string_view text, int& target)
+{
+	return IniHelper::ParseNumber(text, target);
+}
+
+static bool ParseConfigValue(std::string_view text, float& target)
+{
+	return IniHelper::ParseNumber(text, target);
+}
+
+static bool ParseConfigValue(std::string_view text, std::string& target)
+{
+	target.assign(text);
+	return true;
+}
+
+static bool ParseConfigSetting(const ConfigSetting& setting, std::string_view text)
+{
+	return std::visit([text](const auto& typed) { return ParseConfigValue(text, *typed.target); }, setting.value);
+}
+
+static void ReportConfigIssues(const ConfigReport& report)
+{
+	for (size_t i = 0; i < report.count; i++)
+	{
+		const ConfigIssue& issue = report.issues[i];
+
+		char message[0x200];
+		sprintf_s(message, "MadnessPatch: %s [%.*s] %.*s\n", issue.reason,
+			static_cast<int>(issue.section.size()), issue.section.data(),
+			static_cast<int>(issue.key.size()), issue.key.data());
+		OutputDebugStringA(message);
+	}
+}
+
+static const wchar_t* StoreConfigName(std::string_view name)
+{
+	int length = MultiByteToWideChar(CP_UTF8, 0, name.data(), static_cast<int>(name.size()), nullptr, 0);
+	if (name.empty() || length <= 0)
+		return nullptr;
+
+	wchar_t* result = g_configArena.AllocateArray<wchar_t>(length + 1);
+	if (!result)
+		return nullptr;
+
+	MultiByteToWideChar(CP_UTF8, 0, name.data(), static_cast<int>(name.size()), result, length);
+	result[length] = L'\0';
+	return result;
+}
+
+static bool ConvertConfigValue(std::string_view value, wchar_t (&result)[CONFIG_VALUE_LENGTH])
+{
+	int length = 0;
+	if (!value.empty())
+	{
+		length = MultiByteToWideChar(CP_UTF8, 0, value.data(), static_cast<int>(value.size()), result, CONFIG_VALUE_LENGTH - 1);
+		if (length <= 0)
+			return false;
+	}
+
+	result[length] = L'\0';
+	return true;
+}
+
+static void LoadEngineOverrides(ConfigReport& report)
+{
+	size_t builtinCount = g_configOverrideCount;
+
+	for (const IniHelper::IniEntry& entry : IniHelper::Entries())
+	{
+		if (!entry.section.starts_with(ENGINE_OVERRIDES_PREFIX))
+			continue;
+
+		std::string_view engineSection = entry.section.substr(ENGINE_OVERRIDES_PREFIX.size());
+		wchar_t value[CONFIG_VALUE_LENGTH];
+		if (!ConvertConfigValue(entry.value, value))
+		{
+			report.Add(entry.section, entry.key, "Value too long for");
+			continue;
+		}
+
+		const wchar_t* section = StoreConfigName(engineSection);
+		const wchar_t* key = StoreConfigName(entry.key);
+
+		if (!section || !key)
+		{
+			report.Add(entry.section, entry.key, "Unable to store override");
+			continue;
+		}
+
+		// Overriding a key the patch already handles replaces its value, the last duplicate wins
+		ConfigOverride* target = nullptr;
+		for (size_t i = 0; i < g_configOverrideCount && !target; i++)
+		{
+			if (_wcsicmp(g_configOverrides[i].key, key) == 0 && _wcsicmp(g_configOverrides[i].section, section) == 0)
+				target = &g_configOverrides[i];
+		}
+
+		if (!target)
+		{
+			if (g_configOverrideCount == MAX_CONFIG_OVERRIDES)
+			{
+				report.Add(entry.section, entry.key, "Too many overrides, ignoring");
+				continue;
+			}
+
+			target = &g_configOverrides[g_configOverrideCount++];
+			target->section = section;
+			target->key = key;
+		}
+
+		wcscpy_s(target->value, value);
+		target->isEnabled = &g_userConfigOverrideEnabled;
+	}
+
+	if (g_configOverrideCount == builtinCount)
+		return;
+
+	ConfigOverrideIndex index = BuildConfigOverrideIndex({ g_configOverrides.data(), g_configOverrideCount });
+	if (index.isValid)
+	{
+		g_configOverrideIndex = index;
+	}
+	else
+	{
+		g_configOverrideCount = builtinCount;
+		report.Add(ENGINE_OVERRIDES_PREFIX, "*", "Unable to index overrides, ignoring");
+	}
+}
+
+// Framerate limit for MaxFPS, following the refresh rate of the given monitor when MaxFPS = -1
+static float ResolveTargetFPS(HMONITOR monitor)
+{
+	if (MaxFPS != MAX_FPS_MATCH_REFRESH)
+		return static_cast<float>(std::max(MaxFPS, 0));
+
+	float refreshRate = static_cast<float>(SystemHelper::GetCurrentDisplayFrequency(monitor));
+
+	// Stay inside the VRR range so frames never wait on vsync (144 Hz -> 138 FPS)
+	if (VRRFriendlyFPS)
+		refreshRate -= refreshRate * refreshRate / 3600.0f;
+
+	return refreshRate;
+}
+
+static ConfigReport ReadConfig()
+{
+	ConfigReport report;
+
+	IniHelper::Init();
+
+	for (const ConfigSetting& setting : g_configSchema)
+	{
+		ApplyConfigDefault(setting);
+	}
+
+	for (const IniHelper::IniEntry& entry : IniHelper::Entries())
+	{
+		if (entry.section.starts_with(ENGINE_OVERRIDES_PREFIX))
+			continue;
+
+		const ConfigSetting* setting = FindConfigSetting(entry.section, entry.key);
+
+		if (!setting)
+		{
+			report.Add(entry.section, entry.key, "Unknown setting");
+		}
+		else if (!ParseConfigSetting(*setting, entry.value))
+		{
+			report.Add(entry.section, entry.key, "Invalid value for");
+		}
+	}
+
+	// A benchmark needs a map to load and at least a second to record
+	if (RunBenchmark && BenchmarkMap.empty())
+	{
+		report.Add("Benchmark", "BenchmarkMap", "Benchmark disabled, missing");
+		RunBenchmark = false;
+	}
+
+	BenchmarkSeconds = std::max(BenchmarkSeconds, 1);
+
+	// Benchmark runs skip the intros and always record
+	if (RunBenchmark)
+	{
+		SkipEAIntro = true;
+		SkipSHIntro = true;
+		SkipUEIntro = true;
+		RecordFrameStats = true;
+	}
+
+	// Physics step
+	PhysicsStepRate = std::max(PhysicsStepRate, 1);
+	g_State.physicsStep = 1.0f / PhysicsStepRate;
+	PhysicsUpdateRate = std::max(PhysicsUpdateRate, 1);
+	g_State.physicsUpdateInterval = 1.0f / PhysicsUpdateRate;
+
+	// Loading tick rate
+	LoadingFPS = std::max(LoadingFPS, 1);
+	LoadingMaxFPS = std::max(LoadingMaxFPS, LoadingFPS);
+
+	// MaxSmoothedFrameRate
+	g_State.targetFPS = ResolveTargetFPS(NULL);
+	EnableMaxSmoothedFrameRate = g_State.targetFPS > 0.0f;
+	UpdateConfigInt(L"Engine.Engine", L"MaxSmoothedFrameRate", static_cast<int>(g_State.targetFPS));
+
+	// Windowed
+	UpdateConfigBool(L"SystemSettings", L"Fullscreen", !UseWindowed);
+	UseWindowed = true; // Can default to windowed if set to AliceEngine.ini
+
+	// DisableMouseSmoothing
+	UpdateConfigBool(L"Engine.PlayerInput", L"bEnableMouseSmoothing", !DisableMouseSmoothing);
+	DisableMouseSmoothing = true;
+
+	// DisableLegacyDriverHacks
+	UpdateConfigBool(L"Engine.ISVHacks", L"DisableATITextureFilterOptimizationChecks", !DisableLegacyDriverHacks);
+	UpdateConfigBool(L"Engine.ISVHacks", L"UseMinimalNVIDIADriverShaderOptimization", !DisableLegacyDriverHacks);
+	DisableLegacyDriverHacks = true;
+
+	// GIsSpecialPCEdition
+	UpdateConfigBool(L"AliceGame.AliceGameEngine", L"GIsSpecialPCEdition", UnlockCompleteEditionDLC);
+	UnlockCompleteEditionDLC = true;
+
+	// Applied last so they take priority over the settings above
+	LoadEngineOverrides(report);
+
+	return report;
+}
+
+#pragma region Helper
+
+static DWORD ScanModuleSignature(HMODULE Module, std::string_view Signature, const char* PatchName, int FunctionStartCheckCount = -1, bool ShowError = true)
 {
-	auto it = g_configOverrides.find(key);
-	if (it != g_configOverrides.end())
+	DWORD Address = MemoryHelper::FindSignatureAddress(Module, Signature, FunctionStartCheckCount);
+
+	if (Address == 0 && ShowError)
 	{
-		it->second.value = std::to_wstring(value);
+		std::string ErrorMessage = "Error: Unable to find signature for patch: ";
+		ErrorMessage += PatchName;
+		MessageBoxA(NULL, ErrorMessage.c_str(), "MadnessPatch", MB_ICONERROR);
 	}
+
+	return Address;
 }
 
-static void UpdateConfigBool(const wchar_t* key, bool value)
+static const BindingRule* FindBindingRule(std::wstring_view name)
 {
-	auto it = g_configOverrides.find(key);
-	if (it != g_configOverrides.end())
+	for (const BindingRule& rule : BINDING_RULES)
 	{
-		it->second.value = value ? L"True" : L"False";
+		if (rule.name == name)
+			return (!rule.isEnabled || *rule.isEnabled) ? &rule : nullptr;
 	}
+	return nullptr;
 }
 
-static void ReadConfig()
+static std::wstring_view TrimBindingSegment(std::wstring_view segment)
+{
+	size_t first = segment.find_first_not_of(L" \t");
+	if (first == std::wstring_view::npos)
+		return {};
+	return segment.substr(first, segment.find_last_not_of(L" \t") - first + 1);
+}
+
+struct BindingWriter
+{
+	wchar_t* buffer;
+	size_t capacity;
+	size_t length = 0;
+	bool overflow = false;
+
+	void Append(wchar_t c)
+	{
+		if (length == capacity)
+		{
+			overflow = true;
+			return;
+		}
+		buffer[length++] = c;
+	}
+
+	void Append(std::wstring_view str)
+	{
+		for (wchar_t c : str)
+		{
+			Append(c);
+		}
+	}
+};
+
+// Streams a command value, normalizing it to "A | B | C"
+struct PipeSpacingWriter
+{
+	BindingWriter& out;
+	size_t start;
+	bool isLeading = true;
+	bool isAfterPipe = false;
+
+	void TrimTrailingSpaces()
+	{
+		while (out.length > start && out.buffer[out.length - 1] == L' ')
+		{
+			out.length--;
+		}
+	}
+
+	void Put(wchar_t c)
+	{
+		// Skip leading pipes and spaces
+		if (isLeading)
+		{
+			if (c == L'|' || c == L' ' || c == L'\t')
+				return;
+			isLeading = false;
+		}
+
+		// Skip spaces after pipe
+		if (isAfterPipe)
+		{
+			if (c == L' ' || c == L'\t')
+				return;
+			isAfterPipe = false;
+		}
+
+		if (c == L'|')
+		{
+			TrimTrailingSpaces();
+			out.Append(L" | ");
+			isAfterPipe = true;
+			return;
+		}
+
+		out.Append(c);
+	}
+
+	void Put(std::wstring_view str)
+	{
+		for (wchar_t c : str)
+		{
+			Put(c);
+		}
+	}
+
+	void DropTrailingPipe()
+	{
+		TrimTrailingSpaces();
+		if (out.length > start && out.buffer[out.length - 1] == L'|')
+		{
+			out.length--;
+			TrimTrailingSpaces();
+		}
+		isAfterPipe = false;
+	}
+};
+
+static void WriteBindingCommand(PipeSpacingWriter& writer, std::wstring_view command, std::wstring_view removedSegment)
+{
+	if (removedSegment.empty())
+	{
+		writer.Put(command);
+		return;
+	}
+
+	size_t segmentStart = 0;
+	for (;;)
+	{
+		size_t pipe = command.find(L'|', segmentStart);
+		bool isLast = pipe == std::wstring_view::npos;
+		std::wstring_view segment = command.substr(segmentStart, isLast ? std::wstring_view::npos : pipe - segmentStart);
+
+		if (TrimBindingSegment(segment) == removedSegment)
+		{
+			// Take the separator along with it
+			if (isLast)
+				writer.DropTrailingPipe();
+		}
+		else
+		{
+			writer.Put(segment);
+			if (!isLast)
+				writer.Put(L'|');
+		}
+
+		if (isLast)
+			break;
+
+		segmentStart = pipe + 1;
+	}
+}
+
+// Single pass over (Name="...",Command="...") applying BINDING_RULES and pipe spacing, true if the line changed
+static bool RewriteInputBinding(std::wstring_view line, BindingWriter& out)
+{
+	static constexpr std::wstring_view namePrefix = L"(Name=\"";
+	static constexpr std::wstring_view commandPrefix = L",Command=\"";
+
+	size_t nameStart = line.find(namePrefix);
+	if (nameStart == std::wstring_view::npos)
+		return false;
+	nameStart += namePrefix.size();
+
+	size_t nameEnd = line.find(L'"', nameStart);
+	if (nameEnd == std::wstring_view::npos)
+		return false;
+
+	size_t commandStart = line.find(commandPrefix, nameEnd);
+	if (commandStart == std::wstring_view::npos)
+		return false;
+	commandStart += commandPrefix.size();
+
+	size_t commandEnd = line.find(L'"', commandStart);
+	if (commandEnd == std::wstring_view::npos)
+		return false;
+
+	std::wstring_view command = line.substr(commandStart, commandEnd - commandStart);
+	std::wstring_view removedSegment;
+
+	out.Append(line.substr(0, commandStart));
+	PipeSpacingWriter writer{ out, out.length };
+
+	if (const BindingRule* rule = FindBindingRule(line.substr(nameStart, nameEnd - nameStart)))
+	{
+		switch (rule->action)
+		{
+		case BindingAction::Replace:
+			if (command == rule->command)
+				command = rule->replacement;
+			break;
+		case BindingAction::Remove:
+			removedSegment = rule->command;
+			break;
+		case BindingAction::Prepend:
+			if (command.find(rule->command) == std::wstring_view::npos)
+			{
+				writer.Put(rule->command);
+				writer.Put(L'|');
+			}
+			break;
+		}
+	}
+
+	WriteBindingCommand(writer, command, removedSegment);
+	writer.TrimTrailingSpaces();
+	out.Append(line.substr(commandEnd));
+
+	return !out.overflow && std::wstring_view(out.buffer, out.length) != line;
+}
+
+static void ReplaceConfigString(safetyhook::Context& ctx, const wchar_t* newString)
+{
+	std::wstring_view line = newString;
+
+	// Reused for every line, grown from the arena when a longer one comes in
+	if (g_bindingBufferLength < line.size() * 2 + 64)
+	{
+		g_bindingBufferLength = line.size() * 2 + 64;
+		g_bindingBuffer = g_inputBindingArena.AllocateArray<wchar_t>(g_bindingBufferLength);
+	}
+
+	BindingWriter out{ g_bindingBuffer, g_bindingBuffer ? g_bindingBufferLength - 1 : 0 };
+
+	// Only update if the string was modified
+	if (!RewriteInputBinding(line, out))
+	{
+		g_pendingRestore.needsRestore = false;
+		return;
+	}
+
+	out.buffer[out.length] = L'\0';
+
+	// Save original values for restoration
+	g_pendingRestore.structAddr = ctx.ebx;
+	g_pendingRestore.originalPtr = *(wchar_t**)(ctx.ebx + 0xC);
+	g_pendingRestore.originalLength = *(int*)(ctx.ebx + 0x10);
+	g_pendingRestore.originalCapacity = *(int*)(ctx.ebx + 0x14);
+	g_pendingRestore.needsRestore = true;
+
+	// Temporarily replace with our buffer, restored after memcpy
+	int newLength = static_cast<int>(out.length);
+	*(wchar_t**)(ctx.ebx + 0xC) = out.buffer;
+	*(int*)(ctx.ebx + 0x10) = newLength;
+	*(int*)(ctx.ebx + 0x14) = newLength;
+}
+
+static std::string WideToUtf8(const wchar_t* str)
+{
+	if (!str || !*str)
+		return {};
+
+	int length = WideCharToMultiByte(CP_UTF8, 0, str, -1, nullptr, 0, nullptr, nullptr);
+	std::string result(length > 0 ? length - 1 : 0, '\0');
+	if (length > 1)
+	{
+		WideCharToMultiByte(CP_UTF8, 0, str, -1, result.data(), length, nullptr, nullptr);
+	}
+	return result;
+}
+
+static bool IsUALPresent()
+{
+	for (const auto& entry : std::stacktrace::current()) 
+	{
+		HMODULE hModule = NULL;
+		if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, (LPCSTR)entry.native_handle(), &hModule)) 
+		{
+			if (GetProcAddress(hModule, "IsUltimateASILoader") != NULL)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+#pragma endregion
+
+#pragma region Hooks
+
+// =========================
+// FixHighFPSHairPhysics
+// =========================
+
+static constexpr int MAX_PHYSICS_SUBSTEPS = 4;
+static constexpr size_t MAX_HAIR_INSTANCES = 256;
+static constexpr ULONGLONG HAIR_INSTANCE_EXPIRY_MS = 2000;
+
+// Set by a simulator call and read by its mid-hooks on the same thread, so instances simulated in parallel can't mix them up
+static thread_local float t_frameTimeScale = 1.0f;
+static thread_local float t_savedHairDeltaTime = 0.0f;
+static thread_local float t_savedClothDeltaTime = 0.0f;
+
+// Time not simulated yet, per hair instance. Slots are claimed with a CAS, the accumulator is only touched by the thread simulating that instance.
+// A slot not simulated for HAIR_INSTANCE_EXPIRY_MS belongs to a destroyed instance and can be claimed again
+struct HairInstanceSlot
+{
+	std::atomic<void*> instance{ nullptr };
+	std::atomic<ULONGLONG> lastUsed{ 0 };
+	float accumulator = 0.0f;
+};
+
+static std::array<HairInstanceSlot, MAX_HAIR_INSTANCES> g_hairInstances;
+
+static float* FindHairAccumulator(void* instance)
+{
+	size_t hash = (reinterpret_cast<uintptr_t>(instance) >> 4) * 2654435761u;
+	ULONGLONG now = GetTickCount64();
+	HairInstanceSlot* expired = nullptr;
+
+	for (size_t i = 0; i < MAX_HAIR_INSTANCES; i++)
+	{
+		HairInstanceSlot& slot = g_hairInstances[(hash + i) % MAX_HAIR_INSTANCES];
+
+		void* current = slot.instance.load(std::memory_order_acquire);
+		if (current == instance)
+		{
+			slot.lastUsed.store(now, std::memory_order_relaxed);
+			return &slot.accumulator;
+		}
+
+		if (current == nullptr)
+		{
+			if (slot.instance.compare_exchange_strong(current, instance, std::memory_order_acq_rel))
+			{
+				slot.lastUsed.store(now, std::memory_order_relaxed);
+				return &slot.accumulator;
+			}
+
+			if (current == instance)
+				return &slot.accumulator;
+		}
+		else if (!expired && now - slot.lastUsed.load(std::memory_order_relaxed) > HAIR_INSTANCE_EXPIRY_MS)
+		{
+			expired = &slot;
+		}
+	}
+
+	// Not found, take over the slot of an instance that is gone
+	if (expired)
+	{
+		void* current = expired->instance.load(std::memory_order_acquire);
+		if (now - expired->lastUsed.load(std::memory_order_relaxed) > HAIR_INSTANCE_EXPIRY_MS &&
+			expired->instance.compare_exchange_strong(current, instance, std::memory_order_acq_rel))
+		{
+			expired->accumulator = 0.0f;
+			expired->lastUsed.store(now, std::memory_order_relaxed);
+			return &expired->accumulator;
+		}
+	}
+
+	// Full, the caller falls back to simulating every frame
+	return nullptr;
+}
+
+safetyhook::InlineHook HairSimulator;
+
+static void __fastcall HairSimulator_Hook(void* thisPtr, int, float delta)
+{
+	float* slot = (FixedPhysicsTimestep || LowRatePhysics) ? FindHairAccumulator(thisPtr) : nullptr;
+
+	if (!slot)
+	{
+		t_frameTimeScale = TARGET_FRAME_TIME / delta;
+		HairSimulator.unsafe_thiscall<void>(thisPtr, delta);
+		return;
+	}
+
+	float& accumulator = *slot;
+
+	if (FixedPhysicsTimestep)
+	{
+		// Whole steps only, the rest carries over to the next frame. Capped so a hitch doesn't snowball
+		const float step = g_State.physicsStep;
+		accumulator = std::min(accumulator + delta, step * MAX_PHYSICS_SUBSTEPS);
+
+		// The solver is tuned for 1/30 s, scale each step to it like the other paths so damping stays right at any step rate
+		t_frameTimeScale = TARGET_FRAME_TIME / step;
+		while (accumulator >= step)
+		{
+			HairSimulator.unsafe_thiscall<void>(thisPtr, step);
+			accumulator -= step;
+		}
+		return;
+	}
+
+	// LowRatePhysics: skip frames until the interval is reached, then simulate all the time since the last update at once
+	accumulator += delta;
+	if (accumulator < g_State.physicsUpdateInterval)
+		return;
+
+	const float elapsed = std::min(accumulator, g_State.physicsUpdateInterval * MAX_PHYSICS_SUBSTEPS);
+	accumulator = 0.0f;
+
+	t_frameTimeScale = TARGET_FRAME_TIME / elapsed;
+	HairSimulator.unsafe_thiscall<void>(thisPtr, elapsed);
+}
+
+// ======================================
+// FixHighFPSProjectileCollisionCheck
+// ======================================
+
+static constexpr size_t MAX_PROJECTILE_INSTANCES = 64;
+static constexpr ULONGLONG PROJECTILE_INSTANCE_EXPIRY_MS = 100;
+
+// Time since the last check, per projectile. Only touched by the game thread.
+// A slot not checked for PROJECTILE_INSTANCE_EXPIRY_MS belongs to a destroyed projectile, a new one at the same address starts fresh
+struct ProjectileSlot
+{
+	int instance = 0;
+	ULONGLONG lastUsed = 0;
+	float elapsed = 0.0f;
+};
+
+static std::array<ProjectileSlot, MAX_PROJECTILE_INSTANCES> g_projectileInstances;
+
+// Sets isNew when the projectile had no live slot yet
+static ProjectileSlot* FindProjectileSlot(int instance, bool& isNew)
+{
+	ULONGLONG now = GetTickCount64();
+	ProjectileSlot* free = nullptr;
+
+	for (ProjectileSlot& slot : g_projectileInstances)
+	{
+		bool expired = slot.instance == 0 || now - slot.lastUsed > PROJECTILE_INSTANCE_EXPIRY_MS;
+
+		if (slot.instance == instance && !expired)
+		{
+			slot.lastUsed = now;
+			isNew = false;
+			return &slot;
+		}
+
+		if (expired && !free)
+			free = &slot;
+	}
+
+	// Full, the caller falls back to checking every frame
+	if (!free)
+		return nullptr;
+
+	free->instance = instance;
+	free->lastUsed = now;
+	free->elapsed = 0.0f;
+	isNew = true;
+	return free;
+}
+
+static SafetyHookInline RangeAttackPawnCollisionCheck{};
+
+static void __fastcall RangeAttackPawnCollisionCheck_Hook(int thisPtr, float DeltaTime)
+{
+	bool isNew = false;
+	ProjectileSlot* slot = FindProjectileSlot(thisPtr, isNew);
+
+	// The hitbox grows with the swept time, so keep it at the 1/30 s size it was tuned for
+	if (!slot)
+	{
+		RangeAttackPawnCollisionCheck.unsafe_fastcall<void>(thisPtr, TARGET_FRAME_TIME);
+		return;
+	}
+
+	// First check of a projectile or a slow frame: check right away, covering at least 1/30 s
+	if (isNew || DeltaTime >= TARGET_FRAME_TIME)
+	{
+		slot->elapsed = 0.0f;
+		RangeAttackPawnCollisionCheck.unsafe_fastcall<void>(thisPtr, std::max(DeltaTime, TARGET_FRAME_TIME));
+		return;
+	}
+
+	// High FPS: one 1/30 s check each time that much time has passed, the rest carries over
+	slot->elapsed += DeltaTime;
+	if (slot->elapsed < TARGET_FRAME_TIME)
+		return;
+
+	slot->elapsed = std::min(slot->elapsed - TARGET_FRAME_TIME, TARGET_FRAME_TIME);
+	RangeAttackPawnCollisionCheck.unsafe_fastcall<void>(thisPtr, TARGET_FRAME_TIME);
+}
+
+// =============================
+// FixHashTableRaceCondition
+// =============================
+
+static constexpr ULONGLONG LOADING_QUIET_MS = 100;
+static constexpr float LOADING_FPS_STEP = 5.0f;
+
+// Bumped by every Localize call, the loader hits it while packages are still streaming in
+static std::atomic<uint32_t> g_localizeCalls{ 0 };
+
+// Holds LoadingFPS while the loader is busy, raises the rate towards LoadingMaxFPS while it stays quiet
+struct LoadingGovernor
+{
+	uint32_t lastCalls = 0;
+	ULONGLONG quietSince = 0;
+	float rate = 0.0f;
+
+	void Begin(ULONGLONG now)
+	{
+		lastCalls = g_localizeCalls.load(std::memory_order_relaxed);
+		quietSince = now;
+		rate = static_cast<float>(LoadingFPS);
+	}
+
+	float Update(ULONGLONG now)
+	{
+		if (!AdaptiveLoadingFPS)
+			return static_cast<float>(LoadingFPS);
+
+		uint32_t calls = g_localizeCalls.load(std::memory_order_relaxed);
+		if (calls != lastCalls)
+		{
+			// Back to the safe rate at once
+			lastCalls = calls;
+			quietSince = now;
+			rate = static_cast<float>(LoadingFPS);
+		}
+		else if (now - quietSince >= LOADING_QUIET_MS)
+		{
+			quietSince = now;
+			rate = std::min(rate + LOADING_FPS_STEP, static_cast<float>(LoadingMaxFPS));
+		}
+
+		return rate;
+	}
+};
+
+static LoadingGovernor g_loadingGovernor;
+
+static constexpr size_t LOCALIZE_TOP_WAITS = 8;
+static constexpr size_t LOCALIZE_KEY_LENGTH = 64;
+static constexpr size_t MAX_LOCALIZE_THREADS = 32;
+
+struct LocalizeThreadStats
+{
+	DWORD threadId = 0;
+	uint32_t calls = 0;
+	int64_t waitTicks = 0;
+	int64_t holdTicks = 0;
+	int64_t maxWaitTicks = 0;
+};
+
+struct LocalizeWait
+{
+	int64_t waitTicks = 0;
+	wchar_t key[LOCALIZE_KEY_LENGTH] = {};
+};
+
+struct LocalizeLockStats
+{
+	std::array<LocalizeThreadStats, MAX_LOCALIZE_THREADS> threads;
+	std::array<LocalizeWait, LOCALIZE_TOP_WAITS> topWaits;
+};
+
+// Serializes Localize, the stats below are only touched while holding it
+static std::mutex g_localizeMutex;
+static LocalizeLockStats g_localizeStats;
+
+// Slot of the calling thread in g_localizeStats, claimed on its first call. Beyond MAX_LOCALIZE_THREADS threads aren't recorded
+static thread_local LocalizeThreadStats* t_localizeThreadStats = nullptr;
+
+// Fixed-size work only, this runs while the lock is held
+static void RecordLocalizeLock(const wchar_t* key, int64_t waitTicks, int64_t holdTicks)
+{
+	if (!t_localizeThreadStats)
+	{
+		DWORD threadId = GetCurrentThreadId();
+		for (LocalizeThreadStats& slot : g_localizeStats.threads)
+		{
+			if (slot.threadId == 0 || slot.threadId == threadId)
+			{
+				slot.threadId = threadId;
+				t_localizeThreadStats = &slot;
+				break;
+			}
+		}
+
+		if (!t_localizeThreadStats)
+			return;
+	}
+
+	LocalizeThreadStats& stats = *t_localizeThreadStats;
+	stats.calls++;
+	stats.waitTicks += waitTicks;
+	stats.holdTicks += holdTicks;
+	stats.maxWaitTicks = std::max(stats.maxWaitTicks, waitTicks);
+
+	// Replaces the shortest of the longest waits, sorted when written
+	LocalizeWait* shortest = &g_localizeStats.topWaits[0];
+	for (LocalizeWait& wait : g_localizeStats.topWaits)
+	{
+		if (wait.waitTicks < shortest->waitTicks)
+			shortest = &wait;
+	}
+
+	if (waitTicks <= shortest->waitTicks)
+		return;
+
+	shortest->waitTicks = waitTicks;
+	wcsncpy_s(shortest->key, key ? key : L"", _TRUNCATE);
+}
+
+// Thread slots stay claimed, only the counters start over
+static LocalizeLockStats TakeLocalizeLockStats()
+{
+	std::lock_guard<std::mutex> lock(g_localizeMutex);
+
+	LocalizeLockStats stats = g_localizeStats;
+	for (LocalizeThreadStats& slot : g_localizeStats.threads)
+	{
+		slot = { slot.threadId };
+	}
+	g_localizeStats.topWaits = {};
+
+	return stats;
+}
+
+// Appends the stats since the last call to MadnessPatch_LocalizeLock.log and starts over
+static void WriteLocalizeLockStats(float loadSeconds)
+{
+	// Written after releasing the lock, so loading threads don't wait on the disk
+	LocalizeLockStats stats = TakeLocalizeLockStats();
+
+	uint32_t totalCalls = 0;
+	int64_t totalWait = 0;
+	int64_t totalHold = 0;
+	for (const LocalizeThreadStats& thread : stats.threads)
+	{
+		totalCalls += thread.calls;
+		totalWait += thread.waitTicks;
+		totalHold += thread.holdTicks;
+	}
+
+	if (totalCalls == 0)
+		return;
+
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	double ticksToMs = 1000.0 / static_cast<double>(frequency.QuadPart);
+
+	std::ofstream log(IniHelper::iniPath.parent_path() / "MadnessPatch_LocalizeLock.log", std::ios::out | std::ios::binary | std::ios::app);
+	if (!log.is_open())
+		return;
+
+	char line[0x200];
+	sprintf_s(line, "Map load: %.2f s, %u calls, %.2f ms waiting, %.2f ms holding the lock\r\n",
+		loadSeconds, totalCalls, totalWait * ticksToMs, totalHold * ticksToMs);
+	log << line;
+
+	for (const LocalizeThreadStats& thread : stats.threads)
+	{
+		if (thread.calls == 0)
+			continue;
+
+		sprintf_s(line, "  Thread %lu: %u calls, wait %.3f ms (max %.3f ms), hold %.3f ms\r\n",
+			thread.threadId, thread.calls, thread.waitTicks * ticksToMs, thread.maxWaitTicks * ticksToMs, thread.holdTicks * ticksToMs);
+		log << line;
+	}
+
+	std::sort(stats.topWaits.begin(), stats.topWaits.end(), [](const LocalizeWait& a, const LocalizeWait& b)
+		{
+			return a.waitTicks > b.waitTicks;
+		});
+
+	for (const LocalizeWait& wait : stats.topWaits)
+	{
+		if (wait.waitTicks == 0)
+			break;
+
+		sprintf_s(line, "  Waited %.3f ms for ", wait.waitTicks * ticksToMs);
+		log << line << WideToUtf8(wait.key) << "\r\n";
+	}
+}
+
+safetyhook::InlineHook Localize;
+
+static DWORD __cdecl Localize_Hook(DWORD* a1, void* a2, const wchar_t* a3, int a4, wchar_t* String1, int a6)
+{
+	g_localizeCalls.fetch_add(1, std::memory_order_relaxed);
+
+	if (!ProfileLocalizeLock)
+	{
+		// Fix a race condition
+		std::lock_guard<std::mutex> lock(g_localizeMutex);
+		return Localize.unsafe_ccall<DWORD>(a1, a2, a3, a4, String1, a6);
+	}
+
+	LARGE_INTEGER waitStart, holdStart, holdEnd;
+	QueryPerformanceCounter(&waitStart);
+
+	std::lock_guard<std::mutex> lock(g_localizeMutex);
+	QueryPerformanceCounter(&holdStart);
+
+	DWORD result = Localize.unsafe_ccall<DWORD>(a1, a2, a3, a4, String1, a6);
+	QueryPerformanceCounter(&holdEnd);
+
+	RecordLocalizeLock(a3, holdStart.QuadPart - waitStart.QuadPart, holdEnd.QuadPart - holdStart.QuadPart);
+	return result;
+}
+
+static SafetyHookInline SetRenderingState{};
+
+static void __cdecl SetRenderingState_Hook(int a1, int a2)
+{
+	if (a1 == 0)
+	{
+		// Rendering is paused
+		g_State.isLoading = true;
+	}
+	else
+	{
+		// Rendering is resumed
+		g_State.isLoading = false;
+	}
+
+	SetRenderingState.unsafe_ccall<void>(a1, a2);
+}
+
+// ======================
+// PreciseFrameLimiter
+// ======================
+
+// QueryPerformanceCounter time, high resolution waitable timer for the coarse part of the wait
+struct WaitableTimerClock
+{
+	HANDLE timer = nullptr;
+	int64_t frequency = 0;
+
+	bool Init()
+	{
+		LARGE_INTEGER qpf;
+		QueryPerformanceFrequency(&qpf);
+		frequency = qpf.QuadPart;
+
+		// Before Windows 10 1803 a timer only wakes up every ~15.6 ms, far longer than the spin, so the engine keeps pacing
+		timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		return timer != nullptr;
+	}
+
+	int64_t Now() const
+	{
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+		return counter.QuadPart;
+	}
+
+	int64_t Frequency() const { return frequency; }
+
+	void Sleep(int64_t ticks)
+	{
+		// Relative due time in 100 ns units
+		LARGE_INTEGER dueTime;
+		dueTime.QuadPart = -(ticks * 10000000 / frequency);
+
+		if (SetWaitableTimerEx(timer, &dueTime, 0, nullptr, nullptr, nullptr, 0))
+		{
+			WaitForSingleObject(timer, INFINITE);
+		}
+	}
+
+	void Spin() const { YieldProcessor(); }
+};
+
+static WaitableTimerClock g_frameClock;
+static FrameLimiter::FramePacer<WaitableTimerClock> g_framePacer(g_frameClock);
+static bool g_framePacerEnabled = false;
+
+// Re-reads the refresh rate when the buffer size changed or the window is now on another monitor
+static void UpdateRefreshRateTarget(int thisp)
 {
-	IniHelper::Init();
-
-	// Fixes
-	FixHighFPSHairPhysics = IniHelper::ReadInteger("Fixes", "FixHighFPSHairPhysics", 1) == 1;
-	FixHighFPSClothPhysics = IniHelper::ReadInteger("Fixes", "FixHighFPSClothPhysics", 1) == 1;
-	FixHighFPSProjectileCollisionCheck = IniHelper::ReadInteger("Fixes", "FixHighFPSProjectileCollisionCheck", 1) == 1;
-	FixHighFPSRagdollDeath = IniHelper::ReadInteger("Fixes", "FixHighFPSRagdollDeath", 1) == 1;
-	FixHashTableRaceCondition = IniHelper::ReadInteger("Fixes", "FixHashTableRaceCondition", 1) == 1;
-	FixInputBinding = IniHelper::ReadInteger("Fixes", "FixInputBinding", 1) == 1;
-	FixWindowHandling = IniHelper::ReadInteger("Fixes", "FixWindowHandling", 1) == 1;
+	ULONGLONG now = GetTickCount64();
+	if (!g_State.refreshRateChanged && now - g_State.lastMonitorCheck < MONITOR_CHECK_INTERVAL_MS)
+		return;
 
-	// General
-	UnlockCompleteEditionDLC = IniHelper::ReadInteger("General", "UnlockCompleteEditionDLC", 1) == 1;
-	DisableLegacyDriverHacks = IniHelper::ReadInteger("General", "DisableLegacyDriverHacks", 1) == 1;
-	CheckAlice1InstallFolder = IniHelper::ReadInteger("General", "CheckAlice1InstallFolder", 1) == 1;
-	SkipEAIntro = IniHelper::ReadInteger("General", "SkipEAIntro", 0) == 1;
-	SkipSHIntro = IniHelper::ReadInteger("General", "SkipSHIntro", 1) == 1;
-	SkipUEIntro = IniHelper::ReadInteger("General", "SkipUEIntro", 1) == 1;
+	g_State.lastMonitorCheck = now;
 
-	// Display
-	FontScaling = IniHelper::ReadInteger("Display", "FontScaling", 1) == 1;
-	FontScalingFactor = IniHelper::ReadFloat("Display", "FontScalingFactor", 1.0f);
-	UseWindowed = IniHelper::ReadInteger("Display", "UseWindowed", 0) == 1;
+	HMONITOR monitor = MonitorFromWindow(g_State.gameWindow, MONITOR_DEFAULTTOPRIMARY);
+	if (!g_State.refreshRateChanged && monitor == g_State.gameMonitor)
+		return;
 
-	// Input
-	DisableMouseAcceleration = IniHelper::ReadInteger("Input", "DisableMouseAcceleration", 1) == 1;
-	DisableControllerAcceleration = IniHelper::ReadInteger("Input", "DisableControllerAcceleration", 0) == 1;
-	DisableMouseSmoothing = IniHelper::ReadInteger("Input", "DisableMouseSmoothing", 0) == 1;
-	SkipCutscenesWithEnter = IniHelper::ReadInteger("Input", "SkipCutscenesWithEnter", 0) == 1;
+	g_State.gameMonitor = monitor;
+	g_State.refreshRateChanged = false;
 
-	// Graphics
-	MaxFPS = IniHelper::ReadInteger("Graphics", "MaxFPS", 120);
-	ForceHighResTextures = IniHelper::ReadInteger("Graphics", "ForceHighResTextures", 1) == 1;
-	ImprovedTextureStreaming = IniHelper::ReadInteger("Graphics", "ImprovedTextureStreaming", 1) == 1;
-	FixUltraWideScreenFOV = IniHelper::ReadInteger("Graphics", "FixUltraWideScreenFOV", 1) == 1;
-	ReducedMipMapBias = IniHelper::ReadInteger("Graphics", "ReducedMipMapBias", 1) == 1;
-	FixBinkVideoBT709 = IniHelper::ReadInteger("Graphics", "FixBinkVideoBT709", 1) == 1;
+	float targetFPS = ResolveTargetFPS(monitor);
+	if (targetFPS == g_State.targetFPS)
+		return;
 
-	// MaxSmoothedFrameRate
-	EnableMaxSmoothedFrameRate = MaxFPS != 0;
-	UpdateConfigInt(L"MaxSmoothedFrameRate", MaxFPS);
+	g_State.targetFPS = targetFPS;
 
-	// Windowed
-	UpdateConfigBool(L"Fullscreen", !UseWindowed);
-	UseWindowed = true; // Can default to windowed if set to AliceEngine.ini
+	// Loading keeps its own rate and restores this one afterwards
+	if (g_State.isLoading && FixHashTableRaceCondition)
+		g_State.original_fps = targetFPS;
+	else
+		*(float*)(thisp + 0x4A8) = targetFPS;
+}
 
-	// DisableMouseSmoothing
-	UpdateConfigBool(L"bEnableMouseSmoothing", !DisableMouseSmoothing);
-	DisableMouseSmoothing = true;
+// ======================
+// RecordFrameStats
+// ======================
 
-	// DisableLegacyDriverHacks
-	UpdateConfigBool(L"DisableATITextureFilterOptimizationChecks", !DisableLegacyDriverHacks);
-	UpdateConfigBool(L"UseMinimalNVIDIADriverShaderOptimization", !DisableLegacyDriverHacks);
-	DisableLegacyDriverHacks = true;
+// About 9 minutes at 120 FPS, longer segments only keep their most recent frames
+static constexpr size_t FRAME_STATS_CAPACITY = 1 << 16;
 
-	// GIsSpecialPCEdition
-	UpdateConfigBool(L"GIsSpecialPCEdition", UnlockCompleteEditionDLC);
-	UnlockCompleteEditionDLC = true;
-}
+static FrameTelemetry::FrameTimeRing<FRAME_STATS_CAPACITY> g_frameTimes;
+static int64_t g_lastFrameTicks = 0;
+static uint32_t g_frameStatsSegment = 0;
+static bool g_frameStatsKeyDown = false;
+static ULONGLONG g_loadStart = 0;
+static float g_lastLoadSeconds = 0.0f;
 
-#pragma region Helper
+// Measured from the end of the last loading screen, so the run only covers uninterrupted gameplay
+static ULONGLONG g_benchmarkStart = 0;
+static bool g_benchmarkDone = false;
 
-static DWORD ScanModuleSignature(HMODULE Module, std::string_view Signature, const char* PatchName, int FunctionStartCheckCount = -1, bool ShowError = true)
+static void RecordFrameTime()
 {
-	DWORD Address = MemoryHelper::FindSignatureAddress(Module, Signature, FunctionStartCheckCount);
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
 
-	if (Address == 0 && ShowError)
+	if (g_lastFrameTicks != 0)
 	{
-		std::string ErrorMessage = "Error: Unable to find signature for patch: ";
-		ErrorMessage += PatchName;
-		MessageBoxA(NULL, ErrorMessage.c_str(), "MadnessPatch", MB_ICONERROR);
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		g_frameTimes.Push(static_cast<float>((now.QuadPart - g_lastFrameTicks) * 1000.0 / frequency.QuadPart));
 	}
 
-	return Address;
+	g_lastFrameTicks = now.QuadPart;
 }
 
-static std::wstring FixPipeSpacing(const std::wstring& input)
+// Appends the stats of the frames since the last dump to MadnessPatch_FrameStats.csv and starts a new segment
+static void WriteFrameStats(const char* reason)
 {
-	std::wstring result;
-	result.reserve(input.length() * 2);
-	size_t i = 0;
+	std::vector<float> frames;
+	g_frameTimes.Snapshot(frames);
+	g_frameTimes.Clear();
 
-	// Skip leading pipes and spaces
-	while (i < input.length() && (input[i] == L'|' || input[i] == L' ' || input[i] == L'\t'))
-	{
-		i++;
-	}
-
-	for (; i < input.length(); i++)
-	{
-		if (input[i] == L'|')
-		{
-			// Remove trailing spaces
-			while (!result.empty() && result.back() == L' ')
-			{
-				result.pop_back();
-			}
+	if (frames.empty())
+		return;
 
-			result += L' ';
-			result += L'|';
+	FrameTelemetry::FrameStats stats = FrameTelemetry::ComputeFrameStats(frames);
 
-			// Skip spaces after pipe
-			while (i + 1 < input.length() && (input[i + 1] == L' ' || input[i + 1] == L'\t'))
-			{
-				i++;
-			}
+	std::filesystem::path csvPath = IniHelper::iniPath.parent_path() / "MadnessPatch_FrameStats.csv";
+	bool writeHeader = !std::filesystem::exists(csvPath);
 
-			result += L' ';
-		}
-		else
-		{
-			result += input[i];
-		}
-	}
+	std::ofstream csv(csvPath, std::ios::out | std::ios::binary | std::ios::app);
+	if (!csv.is_open())
+		return;
 
-	// Remove trailing spaces
-	while (!result.empty() && result.back() == L' ')
+	if (writeHeader)
 	{
-		result.pop_back();
+		csv << "Segment,Reason,MaxFPS,LoadS,Frames,DurationS,AvgMs,AvgFPS,Low1FPS,Low01FPS,WorstMs,Hitches\r\n";
 	}
 
-	return result;
+	char line[0x100];
+	sprintf_s(line, "%u,%s,%.0f,%.2f,%zu,%.2f,%.3f,%.2f,%.2f,%.2f,%.3f,%zu\r\n",
+		g_frameStatsSegment++, reason, g_State.targetFPS, g_lastLoadSeconds, stats.frames, stats.durationSeconds,
+		stats.averageMs, stats.averageFps, stats.low1Fps, stats.low01Fps, stats.worstMs, stats.hitches);
+	csv << line;
 }
 
-static void ReplaceConfigString(safetyhook::Context& ctx, const wchar_t* newString)
+static BOOL CALLBACK FindGameWindowProc(HWND hwnd, LPARAM lParam)
 {
-	std::wstring str(newString);
-	bool wasModified = false;
+	DWORD processId = 0;
+	GetWindowThreadProcessId(hwnd, &processId);
 
-	// Workaround for automatic movement 
-	if (str == L"(Name=\"MoveForward\",Command=\"Axis aBaseY Speed=1.0\")")
+	if (processId == GetCurrentProcessId() && IsWindowVisible(hwnd) && !GetWindow(hwnd, GW_OWNER))
 	{
-		str = L"(Name=\"MoveForward\",Command=\"Axis aBaseY Speed=1.0 | OnRelease Axis aBaseY Speed=0.0\")";
-		wasModified = true;
+		*reinterpret_cast<HWND*>(lParam) = hwnd;
+		return FALSE;
 	}
+	return TRUE;
+}
 
-	// Check if this is a config line that needs pipe spacing fixes or command modifications
-	if (str.find(L"(Name=") != std::wstring::npos && str.find(L",Command=") != std::wstring::npos)
+// Known from UpdateMouseLock with FixWindowHandling, looked up otherwise (again once a splash screen is gone)
+static HWND GetGameWindow()
+{
+	if (!g_State.gameWindow || !IsWindow(g_State.gameWindow))
 	{
-		// Find the Command=" part
-		size_t commandPos = str.find(L",Command=\"");
-		if (commandPos != std::wstring::npos)
-		{
-			commandPos += 10; // Move past ',Command="'
-
-			// Find the closing quote
-			size_t endQuotePos = str.find(L'"', commandPos);
-			if (endQuotePos != std::wstring::npos)
-			{
-				// Extract the command value
-				std::wstring commandValue = str.substr(commandPos, endQuotePos - commandPos);
-				std::wstring originalCommandValue = commandValue;
-
-				// Handle SkipCutscenesWithEnter
-				if (SkipCutscenesWithEnter)
-				{
-					// Check if this is the SpaceBar binding
-					if (str.find(L"(Name=\"SpaceBar\"") != std::wstring::npos)
-					{
-						// Remove "TryToCancelMatinee" from the command
-						size_t pos = commandValue.find(L"TryToCancelMatinee");
-						if (pos != std::wstring::npos)
-						{
-							size_t startPos = pos;
-							size_t endPos = pos + wcslen(L"TryToCancelMatinee");
-
-							// Remove trailing " | "
-							if (endPos + 3 <= commandValue.length() && commandValue.substr(endPos, 3) == L" | ")
-							{
-								endPos += 3;
-							}
-							// Or remove leading " | "
-							else if (startPos >= 3 && commandValue.substr(startPos - 3, 3) == L" | ")
-							{
-								startPos -= 3;
-							}
-
-							commandValue = commandValue.substr(0, startPos) + commandValue.substr(endPos);
-						}
-					}
-					// Check if this is the Enter binding
-					else if (str.find(L"(Name=\"Enter\"") != std::wstring::npos)
-					{
-						// Add "TryToCancelMatinee" if not already present
-						if (commandValue.find(L"TryToCancelMatinee") == std::wstring::npos)
-						{
-							// Add to the beginning
-							commandValue = L"TryToCancelMatinee | " + commandValue;
-						}
-					}
-				}
-
-				// Fix pipe spacing
-				std::wstring fixedCommand = FixPipeSpacing(commandValue);
-
-				// Check if anything changed
-				if (fixedCommand != originalCommandValue)
-				{
-					str = str.substr(0, commandPos) + fixedCommand + str.substr(endQuotePos);
-					wasModified = true;
-				}
-			}
-		}
+		g_State.gameWindow = NULL;
+		EnumWindows(&FindGameWindowProc, reinterpret_cast<LPARAM>(&g_State.gameWindow));
 	}
+	return g_State.gameWindow;
+}
+
+// Writes the run's stats once BenchmarkSeconds have passed and closes the game
+static void UpdateBenchmark()
+{
+	if (g_benchmarkDone || g_State.isLoading)
+		return;
 
-	// Only allocate and update if the string was modified
-	if (wasModified)
+	ULONGLONG now = GetTickCount64();
+	if (g_benchmarkStart == 0)
 	{
-		// Save original values for restoration
-		g_pendingRestore.structAddr = ctx.ebx;
-		g_pendingRestore.originalPtr = *(wchar_t**)(ctx.ebx + 0xC);
-		g_pendingRestore.originalLength = *(int*)(ctx.ebx + 0x10);
-		g_pendingRestore.originalCapacity = *(int*)(ctx.ebx + 0x14);
-		g_pendingRestore.needsRestore = true;
+		g_benchmarkStart = now;
+		return;
+	}
 
-		// Create our fixed string
-		int newLength = str.length();
-		auto fixedString = std::make_unique<wchar_t[]>(newLength + 1);
-		wcscpy_s(fixedString.get(), newLength + 1, str.c_str());
+	if (now - g_benchmarkStart < static_cast<ULONGLONG>(BenchmarkSeconds) * 1000)
+		return;
 
-		// Temporarily replace with our pointer
-		*(wchar_t**)(ctx.ebx + 0xC) = fixedString.get();
-		*(int*)(ctx.ebx + 0x10) = newLength;
-		*(int*)(ctx.ebx + 0x14) = newLength;
+	g_benchmarkDone = true;
+	WriteFrameStats("Benchmark");
 
-		// Store to keep alive during memcpy
-		g_tempFixedStrings.push_back(std::move(fixedString));
-	}
-	else
+	// Same path as closing the window, lets the engine shut down normally
+	HWND gameWindow = GetGameWindow();
+	if (gameWindow)
 	{
-		g_pendingRestore.needsRestore = false;
+		PostMessageW(gameWindow, WM_CLOSE, 0, 0);
 	}
 }
 
-static bool IsUALPresent()
+// ======================
+// Background throttling
+// ======================
+
+// Holds the game thread in short slices while unfocused. Not a pause: one tick goes through every BACKGROUND_IDLE_MAX_MS (about 4 per second)
+// so window messages get pumped, and the game keeps running at that rate
+static void WaitInBackground()
 {
-	for (const auto& entry : std::stacktrace::current()) 
+	ULONGLONG start = GetTickCount64();
+	while (GetForegroundWindow() != g_State.gameWindow && GetTickCount64() - start < BACKGROUND_IDLE_MAX_MS)
 	{
-		HMODULE hModule = NULL;
-		if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, (LPCSTR)entry.native_handle(), &hModule)) 
-		{
-			if (GetProcAddress(hModule, "IsUltimateASILoader") != NULL)
-				return true;
-		}
+		Sleep(BACKGROUND_IDLE_SLICE_MS);
 	}
-
-	return false;
 }
 
-#pragma endregion
-
-#pragma region Hooks
+static SafetyHookInline GetMaxTickRate{};
 
-// =========================
-// FixHighFPSHairPhysics
-// =========================
+static double __fastcall GetMaxTickRate_Hook(int thisp, int, float a2, int a3)
+{
+	if (MaxFPS == MAX_FPS_MATCH_REFRESH)
+	{
+		UpdateRefreshRateTarget(thisp);
+	}
 
-safetyhook::InlineHook HairSimulator;
+	if (g_State.isLoading != g_State.prev_isLoading)
+	{
+		if (g_State.isLoading)
+		{
+			// Save original FPS before slowing down loading at high fps
+			if (FixHashTableRaceCondition)
+			{
+				g_State.original_fps = *(float*)(thisp + 0x4A8);
+				g_loadingGovernor.Begin(GetTickCount64());
+			}
 
-static void __fastcall HairSimulator_Hook(void* thisPtr, int, float delta)
-{
-	g_State.frameTimeScale = TARGET_FRAME_TIME / delta;
-	HairSimulator.unsafe_thiscall<void>(thisPtr, delta);
-}
+			// One segment per map, loading frames are left out
+			if (RecordFrameStats)
+				WriteFrameStats("Map");
 
-// ======================================
-// FixHighFPSProjectileCollisionCheck
-// ======================================
+			g_loadStart = GetTickCount64();
+			g_benchmarkStart = 0;
 
-static SafetyHookInline RangeAttackPawnCollisionCheck{};
+			// Only the load itself is reported
+			if (ProfileLocalizeLock)
+				TakeLocalizeLockStats();
+		}
+		else
+		{
+			// Restore original FPS
+			if (FixHashTableRaceCondition)
+				*(float*)(thisp + 0x4A8) = g_State.original_fps;
 
-static void __fastcall RangeAttackPawnCollisionCheck_Hook(int thisPtr, float DeltaTime)
-{
-	DeltaTime = TARGET_FRAME_TIME;
-	RangeAttackPawnCollisionCheck.unsafe_fastcall<void>(thisPtr, DeltaTime);
-}
+			g_lastFrameTicks = 0;
+			g_lastLoadSeconds = (GetTickCount64() - g_loadStart) / 1000.0f;
 
-// =============================
-// FixHashTableRaceCondition
-// =============================
+			if (ProfileLocalizeLock)
+				WriteLocalizeLockStats(g_lastLoadSeconds);
+		}
+		g_State.prev_isLoading = g_State.isLoading;
+	}
 
-safetyhook::InlineHook Localize;
+	if (g_State.isLoading && FixHashTableRaceCondition)
+	{
+		*(float*)(thisp + 0x4A8) = g_loadingGovernor.Update(GetTickCount64());
+	}
 
-static DWORD __cdecl Localize_Hook(DWORD* a1, void* a2, const wchar_t* a3, int a4, wchar_t* String1, int a6)
-{
-	// Fix a race condition
-	static std::mutex locMutex;
-	std::lock_guard<std::mutex> lock(locMutex);
-	return Localize.unsafe_ccall<DWORD>(a1, a2, a3, a4, String1, a6);
-}
+	double maxTickRate = GetMaxTickRate.unsafe_thiscall<double>(thisp, a2, a3);
 
-static SafetyHookInline SetRenderingState{};
+	bool isFocused = true;
+	if (BackgroundMaxFPS > 0 || IdleInBackground)
+	{
+		HWND gameWindow = GetGameWindow();
+		isFocused = !gameWindow || GetForegroundWindow() == gameWindow;
+	}
 
-static void __cdecl SetRenderingState_Hook(int a1, int a2)
-{
-	if (a1 == 0)
+	if (!isFocused)
 	{
-		// Rendering is paused
-		g_State.set40fps = true;
+		if (IdleInBackground)
+			WaitInBackground();
+
+		// Lower the rate for the pacer or the engine's own wait
+		if (BackgroundMaxFPS > 0 && (maxTickRate <= 0.0 || maxTickRate > BackgroundMaxFPS))
+			maxTickRate = BackgroundMaxFPS;
 	}
-	else
+
+	if (g_framePacerEnabled)
 	{
-		// Rendering is resumed
-		g_State.set40fps = false;
+		// Called once per frame before the engine waits, do the waiting here and let the engine run unlimited
+		g_framePacer.Wait(maxTickRate > 0.0 ? maxTickRate : g_State.targetFPS);
+		maxTickRate = 0.0;
 	}
 
-	SetRenderingState.unsafe_ccall<void>(a1, a2);
-}
+	if (RecordFrameStats)
+	{
+		// Loading and background frames would skew the stats
+		if (!g_State.isLoading && isFocused)
+			RecordFrameTime();
+		else
+			g_lastFrameTicks = 0;
 
-static SafetyHookInline GetMaxTickRate{};
+		bool keyDown = (GetAsyncKeyState(FrameStatsKey) & 0x8000) != 0;
+		if (keyDown && !g_frameStatsKeyDown && GetForegroundWindow() == GetGameWindow())
+			WriteFrameStats("Hotkey");
 
-static double __fastcall GetMaxTickRate_Hook(int thisp, int, float a2, int a3)
-{
-	if (g_State.set40fps != g_State.prev_set40fps)
+		g_frameStatsKeyDown = keyDown;
+	}
+
+	if (RunBenchmark)
 	{
-		if (g_State.set40fps)
-		{
-			// Save original FPS before setting to 40 (slow down loading at high fps)
-			g_State.original_fps = *(float*)(thisp + 0x4A8);
-			*(float*)(thisp + 0x4A8) = 40.0f;
-		}
-		else
-		{
-			// Restore original FPS
-			*(float*)(thisp + 0x4A8) = g_State.original_fps;
-		}
-		g_State.prev_set40fps = g_State.set40fps;
+		UpdateBenchmark();
 	}
 
-	return GetMaxTickRate.unsafe_thiscall<double>(thisp, a2, a3);
+	return maxTickRate;
 }
 
 // ======================
@@ -554,6 +1793,10 @@ static void __fastcall LoadStartupPackages_Hook()
 
 	(void)iniInputFix.disable();
 	(void)iniInputFixPtrRestore.disable();
+
+	g_bindingBuffer = nullptr;
+	g_bindingBufferLength = 0;
+	g_inputBindingArena.Release();
 }
 
 // =======================
@@ -583,6 +1826,7 @@ static LONG __fastcall UpdateMouseLock_Hook(int thisPtr, int)
 {
 	HWND gameWindow = *(HWND*)(thisPtr + 0x68);  // Get window handle
 	HWND foregroundWindow = GetForegroundWindow();
+	g_State.gameWindow = gameWindow;
 
 	// Only call original if window has focus
 	if (gameWindow == foregroundWindow)
@@ -601,32 +1845,127 @@ static LONG __fastcall UpdateMouseLock_Hook(int thisPtr, int)
 
 safetyhook::InlineHook GetStringHook;
 
-static unsigned int __fastcall FConfigCacheIni_GetString_Hook(int* thisp, int, const wchar_t* Section, const wchar_t* Key, int* Value, const wchar_t* Filename)
+struct ConfigTraceEntry
+{
+	std::wstring section;
+	std::wstring key;
+	std::wstring filename;
+	uint32_t calls = 0;
+	int64_t originalTicks = 0;
+	int64_t overheadTicks = 0;
+	bool isOverridden = false;
+};
+
+static std::mutex g_configTraceMutex;
+static std::unordered_map<std::wstring, ConfigTraceEntry> g_configTrace;
+
+static void RecordConfigRead(const wchar_t* Section, const wchar_t* Key, const wchar_t* Filename, int64_t originalTicks, int64_t overheadTicks, bool isOverridden)
 {
-	if (Key)
+	std::wstring id = Section;
+	id += L'|';
+	id += Key;
+	id += L'|';
+	id += Filename ? Filename : L"";
+
+	std::lock_guard<std::mutex> lock(g_configTraceMutex);
+
+	auto [it, inserted] = g_configTrace.try_emplace(std::move(id));
+	ConfigTraceEntry& entry = it->second;
+	if (inserted)
 	{
-		auto it = g_configOverrides.find(Key);
-		if (it != g_configOverrides.end() && *it->second.isEnabled)
-		{
-			// Prepare replacement string
-			const wchar_t* newValue = it->second.value.c_str();
-			size_t newLen = wcslen(newValue);
-			auto newString = std::make_unique<wchar_t[]>(newLen + 1);
-			wcscpy_s(newString.get(), newLen + 1, newValue);
+		entry.section = Section;
+		entry.key = Key;
+		entry.filename = Filename ? Filename : L"";
+	}
 
-			g_replacementString = newString.get();
-			g_tempConfigStrings.push_back(std::move(newString));
-		}
-		else
+	entry.calls++;
+	entry.originalTicks += originalTicks;
+	entry.overheadTicks += overheadTicks;
+	entry.isOverridden |= isOverridden;
+}
+
+static void WriteConfigTrace()
+{
+	std::lock_guard<std::mutex> lock(g_configTraceMutex);
+
+	std::vector<const ConfigTraceEntry*> entries;
+	entries.reserve(g_configTrace.size());
+	for (const auto& [id, entry] : g_configTrace)
+	{
+		entries.push_back(&entry);
+	}
+
+	// Most expensive reads first
+	std::sort(entries.begin(), entries.end(), [](const ConfigTraceEntry* a, const ConfigTraceEntry* b)
 		{
-			g_replacementString = nullptr;
-		}
+			return a->originalTicks > b->originalTicks;
+		});
+
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	double ticksToUs = 1000000.0 / static_cast<double>(frequency.QuadPart);
+
+	std::ofstream csv(IniHelper::iniPath.parent_path() / "MadnessPatch_ConfigTrace.csv", std::ios::out | std::ios::binary);
+	if (!csv.is_open())
+		return;
+
+	csv << "Section,Key,Filename,Calls,OriginalTotalUs,OriginalAvgUs,HookOverheadTotalUs,Overridden\r\n";
+
+	char line[0x100];
+	for (const ConfigTraceEntry* entry : entries)
+	{
+		double originalUs = entry->originalTicks * ticksToUs;
+		sprintf_s(line, ",%u,%.2f,%.2f,%.2f,%d\r\n", entry->calls, originalUs, originalUs / entry->calls, entry->overheadTicks * ticksToUs, entry->isOverridden ? 1 : 0);
+
+		csv << '"' << WideToUtf8(entry->section.c_str()) << "\",\"" << WideToUtf8(entry->key.c_str()) << "\",\"" << WideToUtf8(entry->filename.c_str()) << '"' << line;
+	}
+
+	g_configTrace.clear();
+}
+
+static unsigned int __fastcall FConfigCacheIni_GetString_Hook(int* thisp, int, const wchar_t* Section, const wchar_t* Key, int* Value, const wchar_t* Filename)
+{
+	LARGE_INTEGER hookStart = {};
+	if (TraceConfigReads)
+	{
+		QueryPerformanceCounter(&hookStart);
+	}
+
+	if (Section && Key)
+	{
+		const ConfigOverride* entry = FindConfigOverride(Section, Key);
+		g_replacementString = (entry && *entry->isEnabled) ? entry->value : nullptr;
+	}
+
+	if (!TraceConfigReads)
+	{
+		int result = GetStringHook.thiscall<unsigned int>(thisp, Section, Key, Value, Filename);
+
+		// Clear after use
+		g_replacementString = nullptr;
+		return result;
 	}
 
+	bool isOverridden = g_replacementString != nullptr;
+
+	LARGE_INTEGER originalStart, originalEnd;
+	QueryPerformanceCounter(&originalStart);
 	int result = GetStringHook.thiscall<unsigned int>(thisp, Section, Key, Value, Filename);
+	QueryPerformanceCounter(&originalEnd);
 
 	// Clear after use
 	g_replacementString = nullptr;
+
+	LARGE_INTEGER hookEnd;
+	QueryPerformanceCounter(&hookEnd);
+
+	if (Section && Key)
+	{
+		int64_t originalTicks = originalEnd.QuadPart - originalStart.QuadPart;
+		int64_t overheadTicks = (hookEnd.QuadPart - hookStart.QuadPart) - originalTicks;
+		RecordConfigRead(Section, Key, Filename, originalTicks, overheadTicks, isOverridden);
+	}
+
 	return result;
 }
 
@@ -641,6 +1980,11 @@ static void __fastcall UpdateD3DDeviceFromViewports_Hook(int thisp, int)
 	(void)GetStringHook.disable();
 	(void)ConfigStringReplace.disable();
 	(void)UpdateD3DDeviceFromViewports.disable();
+
+	if (TraceConfigReads)
+	{
+		WriteConfigTrace();
+	}
 }
 
 // ==================
@@ -751,6 +2095,9 @@ static void __fastcall SetBufferSize_Hook(int thisp, int, int InBufferSizeX, int
 
 	g_State.scaleFactor = g_State.screenWidth / g_State.screenHeight;
 
+	// Display mode may have changed along with the resolution
+	g_State.refreshRateChanged = true;
+
 	if (FixUltraWideScreenFOV)
 	{
 		if (g_State.scaleFactor > ASPECT_RATIO_16_9)
@@ -797,9 +2144,9 @@ static void ApplyFixHighFPSHairPhysics()
 		[](safetyhook::Context& ctx)
 		{
 			// Scale damping factors
-			ctx.xmm3.f32[0] = ctx.xmm3.f32[0] / g_State.frameTimeScale;
-			ctx.xmm1.f32[0] = ctx.xmm1.f32[0] / g_State.frameTimeScale;
-			ctx.xmm4.f32[0] = ctx.xmm4.f32[0] / g_State.frameTimeScale;
+			ctx.xmm3.f32[0] = ctx.xmm3.f32[0] / t_frameTimeScale;
+			ctx.xmm1.f32[0] = ctx.xmm1.f32[0] / t_frameTimeScale;
+			ctx.xmm4.f32[0] = ctx.xmm4.f32[0] / t_frameTimeScale;
 		}
 	);
 
@@ -810,8 +2157,8 @@ static void ApplyFixHighFPSHairPhysics()
 			uint32_t ebx = ctx.ebx;
 
 			float* deltaTime = (float*)(ebx + 0x8);
-			g_State.savedHairDeltaTime = *deltaTime;
-			*deltaTime = *deltaTime * g_State.frameTimeScale;
+			t_savedHairDeltaTime = *deltaTime;
+			*deltaTime = *deltaTime * t_frameTimeScale;
 		}
 	);
 
@@ -822,7 +2169,7 @@ static void ApplyFixHighFPSHairPhysics()
 			uint32_t ebx = ctx.ebx;
 
 			float* deltaTime = (float*)(ebx + 0x8);
-			*deltaTime = g_State.savedHairDeltaTime;
+			*deltaTime = t_savedHairDeltaTime;
 		}
 	);
 }
@@ -843,7 +2190,7 @@ static void ApplyFixHighFPSClothPhysics()
 			uint32_t edx = ctx.edx;
 
 			float* deltaTime = (float*)(ebx + 0x8);
-			g_State.savedClothDeltaTime = *deltaTime;
+			t_savedClothDeltaTime = *deltaTime;
 
 			if (*(float*)(edx + 0xAC) != 32.0f) // skip london dress
 				*deltaTime = TARGET_FRAME_TIME;
@@ -857,7 +2204,7 @@ static void ApplyFixHighFPSClothPhysics()
 			uint32_t ebx = ctx.ebx;
 
 			float* deltaTime = (float*)(ebx + 0x8);
-			*deltaTime = g_State.savedClothDeltaTime;
+			*deltaTime = t_savedClothDeltaTime;
 		}
 	);
 }
@@ -890,20 +2237,43 @@ static void ApplyFixHashTableRaceCondition()
 
 	DWORD addr_Localize = ScanModuleSignature(g_State.GameModule, "55 8B EC 6A FF 68 ?? ?? ?? ?? 64 A1 00 00 00 00 50 83 EC 2C 53 56 57 A1 ?? ?? ?? ?? 33 C5 50 8D 45 F4 64 A3 00 00 00 00 33 DB 89 5D EC 39 1D", "Localize");
 	DWORD addr_hashLoop = ScanModuleSignature(g_State.GameModule, "83 C4 08 85 C0 74 1B 8B 03 8B 7C 06 54 83 FF FF 75 BC 8B 45 08 5F 5E C7 00 FF FF FF FF 5B 5D C2 08 00 8B 45 08 89 38 5F 5E 5B 5D C2 08", "HashLoop");
+
+	if (addr_hashLoop == 0) return;
+
+	Localize = HookHelper::CreateHook((void*)addr_Localize, &Localize_Hook);
+	MemoryHelper::MakeNOP(addr_hashLoop + 0x10, 2);
+}
+
+static void ApplyLoadingStateHook()
+{
+	// Loading screens are tracked for the loading slowdown of FixHashTableRaceCondition and for timing benchmark runs
+	if (!FixHashTableRaceCondition && !RunBenchmark) return;
+
 	DWORD addr_SetRenderingState = ScanModuleSignature(g_State.GameModule, "6A 02 6A 01 E8 ?? ?? ?? ?? 83 C4 08 C3", "SetRenderingState");
 	addr_SetRenderingState = MemoryHelper::ResolveRelativeAddress(addr_SetRenderingState, 0x5);
+
+	if (addr_SetRenderingState == 0) return;
+
+	SetRenderingState = HookHelper::CreateHook((void*)addr_SetRenderingState, &SetRenderingState_Hook);
+}
+
+static void ApplyGetMaxTickRateHook()
+{
+	// Shared by the loading slowdown of FixHashTableRaceCondition, MaxFPS = -1, the frame limiter, frame stats and background throttling
+	g_framePacerEnabled = PreciseFrameLimiter && MaxFPS != 0 && g_frameClock.Init();
+
+	if (!g_framePacerEnabled && !SetRenderingState && MaxFPS != MAX_FPS_MATCH_REFRESH && !RecordFrameStats &&
+		BackgroundMaxFPS <= 0 && !IdleInBackground) return;
+
 	DWORD addr_SetFPSRate = ScanModuleSignature(g_State.GameModule, "55 8B EC 6A FF 68 ?? ?? ?? ?? 64 A1 00 00 00 00 50 83 EC 14 56 A1 ?? ?? ?? ?? 33 C5 50 8D 45 F4 64 A3 00 00 00 00 8B F1 C7 45 EC 00 00 00 00 F7", "GetMaxTickRate");
 
-	if (addr_hashLoop == 0 ||
-		addr_SetRenderingState == 0 ||
-		addr_SetFPSRate == 0) {
+	if (addr_SetFPSRate == 0)
+	{
+		g_framePacerEnabled = false;
 		return;
 	}
 
-	Localize = HookHelper::CreateHook((void*)addr_Localize, &Localize_Hook);
-	SetRenderingState = HookHelper::CreateHook((void*)addr_SetRenderingState, &SetRenderingState_Hook);
 	GetMaxTickRate = HookHelper::CreateHook((void*)addr_SetFPSRate, &GetMaxTickRate_Hook);
-	MemoryHelper::MakeNOP(addr_hashLoop + 0x10, 2);
 }
 
 static void ApplyFixInputBinding()
@@ -1397,7 +2767,10 @@ static void ApplyGetPointerHook()
 
 static void Init()
 {
-	ReadConfig();
+	ReportConfigIssues(ReadConfig());
+
+	// Nothing refers to the mapped file past this point, don't keep it locked while the game runs
+	IniHelper::Close();
 
 	// Fixes
 	ApplyFixHighFPSHairPhysics();
@@ -1405,6 +2778,8 @@ static void Init()
 	ApplyFixHighFPSProjectileCollisionCheck();
 	ApplyFixHighFPSRagdollDeath();
 	ApplyFixHashTableRaceCondition();
+	ApplyLoadingStateHook();
+	ApplyGetMaxTickRateHook();
 	ApplyFixInputBinding();
 	ApplyFixWindowHandling();
 
@@ -1430,6 +2805,57 @@ static void Init()
 	ApplyGetPointerHook();
 }
 
+// ======================
+// Benchmark
+// ======================
+
+safetyhook::InlineHook hkGetCommandLineW;
+static std::wstring g_benchmarkCommandLine;
+
+static LPWSTR WINAPI GetCommandLineW_Hook()
+{
+	return g_benchmarkCommandLine.data();
+}
+
+// The engine parses its command line long before Init, so [Benchmark] is read on attach
+static void ApplyBenchmarkCommandLine()
+{
+	IniHelper::Init();
+
+	for (const ConfigSetting& setting : g_configSchema)
+	{
+		if (setting.section == "Benchmark")
+			ApplyConfigDefault(setting);
+	}
+
+	for (const IniHelper::IniEntry& entry : IniHelper::Entries())
+	{
+		const ConfigSetting* setting = FindConfigSetting(entry.section, entry.key);
+		if (setting && setting->section == "Benchmark")
+			ParseConfigSetting(*setting, entry.value);
+	}
+
+	IniHelper::Close();
+
+	if (!RunBenchmark || BenchmarkMap.empty()) return;
+
+	// "Game.exe" -args -> "Game.exe" Map -args
+	std::wstring_view commandLine = GetCommandLineW();
+	size_t exeEnd = commandLine.starts_with(L'"') ? commandLine.find(L'"', 1) : commandLine.find(L' ');
+	exeEnd = exeEnd == std::wstring_view::npos ? commandLine.size() : exeEnd + (commandLine.starts_with(L'"') ? 1 : 0);
+
+	int mapLength = MultiByteToWideChar(CP_UTF8, 0, BenchmarkMap.data(), static_cast<int>(BenchmarkMap.size()), nullptr, 0);
+	std::wstring map(mapLength, L'\0');
+	MultiByteToWideChar(CP_UTF8, 0, BenchmarkMap.data(), static_cast<int>(BenchmarkMap.size()), map.data(), mapLength);
+
+	g_benchmarkCommandLine.assign(commandLine.substr(0, exeEnd));
+	g_benchmarkCommandLine += L' ';
+	g_benchmarkCommandLine += map;
+	g_benchmarkCommandLine += commandLine.substr(exeEnd);
+
+	hkGetCommandLineW = HookHelper::CreateHookAPI(L"kernel32.dll", "GetCommandLineW", &GetCommandLineW_Hook);
+}
+
 safetyhook::InlineHook hkCreateMutexW;
 static HANDLE WINAPI CreateMutexW_Hook(LPSECURITY_ATTRIBUTES lpMutexAttributes, BOOL bInitialOwner, LPCWSTR lpName)
 {
@@ -1478,11 +2904,16 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserv
 				SystemHelper::LoadProxyLibrary();
 			}
 
+			ApplyBenchmarkCommandLine();
 			hkCreateMutexW = HookHelper::CreateHookAPI(L"kernel32.dll", "CreateMutexW", &CreateMutexW_Hook);
 			break;
 		}
 		case DLL_PROCESS_DETACH:
 		{
+			if (RecordFrameStats && GetMaxTickRate)
+			{
+				WriteFrameStats("Exit");
+			}
 			break;
 		}
 	}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+// Frame pacing kept free of platform calls so it can be driven by a fake clock.
+//
+// Clock needs:
+//   int64_t Now()              current time in ticks
+//   int64_t Frequency()        ticks per second
+//   void Sleep(int64_t ticks)  coarse wait, allowed to overshoot
+//   void Spin()                one iteration of a busy wait
+namespace FrameLimiter
+{
+	template <typename Clock> class FramePacer
+	{
+	public:
+		explicit FramePacer(Clock& clock) : clock(clock) {}
+
+		// Blocks until the next frame is due. A rate of 0 or less disables pacing
+		void Wait(double targetFps)
+		{
+			if (targetFps <= 0.0)
+			{
+				Reset();
+				return;
+			}
+
+			const int64_t frequency = clock.Frequency();
+			const int64_t frameTicks = static_cast<int64_t>(frequency / targetFps);
+			const int64_t now = clock.Now();
+
+			// First frame or more than a frame behind: restart the cadence from now
+			if (nextFrame == 0 || now - nextFrame > frameTicks)
+			{
+				if (spinTicks == 0)
+					spinTicks = frequency / 1000;
+
+				currentFrameTicks = frameTicks;
+				nextFrame = now + frameTicks;
+				return;
+			}
+
+			// New rate, the engine's value drifts a little every frame: keep the last boundary and apply the new period from there
+			if (frameTicks != currentFrameTicks)
+			{
+				nextFrame += frameTicks - currentFrameTicks;
+				currentFrameTicks = frameTicks;
+			}
+
+			// Slightly late, keep the cadence so the next frame catches up
+			if (now >= nextFrame)
+			{
+				nextFrame += frameTicks;
+				return;
+			}
+
+			// Sleep through most of the wait, leave the rest to the spin
+			const int64_t sleepTicks = nextFrame - now - spinTicks;
+			if (sleepTicks > 0)
+			{
+				clock.Sleep(sleepTicks);
+				Calibrate(clock.Now() - now - sleepTicks, frequency);
+			}
+
+			while (clock.Now() < nextFrame)
+				clock.Spin();
+
+			nextFrame += frameTicks;
+		}
+
+		void Reset()
+		{
+			nextFrame = 0;
+			currentFrameTicks = 0;
+		}
+
+		int64_t SpinTicks() const { return spinTicks; }
+
+	private:
+		// Keeps the spin slightly longer than the usual sleep overshoot
+		void Calibrate(int64_t overshoot, int64_t frequency)
+		{
+			const int64_t minSpin = frequency / 10000; // 0.1 ms
+			const int64_t maxSpin = frequency / 250;   // 4 ms
+
+			// Grow at once on a late wake-up, shrink slowly once the timer behaves
+			int64_t wanted = overshoot + overshoot / 2;
+			if (wanted > spinTicks)
+				spinTicks = wanted;
+			else
+				spinTicks -= (spinTicks - wanted) / 16;
+
+			spinTicks = std::clamp(spinTicks, minSpin, maxSpin);
+		}
+
+		Clock& clock;
+		int64_t nextFrame = 0;
+		int64_t currentFrameTicks = 0;
+		int64_t spinTicks = 0;
+	};
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Frame time collection and summary, no platform calls
+namespace FrameTelemetry
+{
+	// Written by the game thread only, readers copy whatever was pushed last
+	template <size_t Capacity> class FrameTimeRing
+	{
+	public:
+		void Push(float frameMs)
+		{
+			uint32_t index = head.load(std::memory_order_relaxed);
+			samples[index % Capacity] = frameMs;
+			head.store(index + 1, std::memory_order_release);
+		}
+
+		// Copies the most recent frames, oldest first
+		void Snapshot(std::vector<float>& out) const
+		{
+			uint32_t end = head.load(std::memory_order_acquire);
+			uint32_t begin = std::max<uint32_t>(start.load(std::memory_order_relaxed), end > Capacity ? end - static_cast<uint32_t>(Capacity) : 0);
+
+			out.clear();
+			out.reserve(end - begin);
+			for (uint32_t i = begin; i != end; i++)
+			{
+				out.push_back(samples[i % Capacity]);
+			}
+		}
+
+		// Starts a new segment without touching the samples
+		void Clear()
+		{
+			start.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+
+	private:
+		std::array<float, Capacity> samples{};
+		std::atomic<uint32_t> head{ 0 };
+		std::atomic<uint32_t> start{ 0 };
+	};
+
+	struct FrameStats
+	{
+		size_t frames = 0;
+		double durationSeconds = 0.0;
+		double averageMs = 0.0;
+		double averageFps = 0.0;
+		double low1Fps = 0.0;   // Average of the slowest 1% of frames, as FPS
+		double low01Fps = 0.0;  // Average of the slowest 0.1% of frames, as FPS
+		double worstMs = 0.0;
+		size_t hitches = 0;     // Frames taking longer than hitchFactor times the median
+	};
+
+	// Reorders frameMs
+	inline FrameStats ComputeFrameStats(std::span<float> frameMs, float hitchFactor = 2.0f)
+	{
+		FrameStats stats;
+		stats.frames = frameMs.size();
+		if (frameMs.empty())
+			return stats;
+
+		double total = 0.0;
+		for (float ms : frameMs)
+		{
+			total += ms;
+		}
+
+		stats.durationSeconds = total / 1000.0;
+		stats.averageMs = total / frameMs.size();
+		stats.averageFps = stats.averageMs > 0.0 ? 1000.0 / stats.averageMs : 0.0;
+
+		std::sort(frameMs.begin(), frameMs.end());
+
+		// At least one frame, so a low can never be above the average
+		auto slowestAverage = [&](double fraction)
+			{
+				size_t count = std::max<size_t>(1, static_cast<size_t>(std::ceil(fraction * frameMs.size())));
+				double slowest = 0.0;
+				for (size_t i = frameMs.size() - count; i < frameMs.size(); i++)
+				{
+					slowest += frameMs[i];
+				}
+				return slowest / count;
+			};
+
+		double slowest1 = slowestAverage(0.01);
+		double slowest01 = slowestAverage(0.001);
+		stats.low1Fps = slowest1 > 0.0 ? 1000.0 / slowest1 : 0.0;
+		stats.low01Fps = slowest01 > 0.0 ? 1000.0 / slowest01 : 0.0;
+		stats.worstMs = frameMs.back();
+
+		float hitchMs = frameMs[frameMs.size() / 2] * hitchFactor;
+		stats.hitches = frameMs.end() - std::upper_bound(frameMs.begin(), frameMs.end(), hitchMs);
+
+		return stats;
+	}
+}
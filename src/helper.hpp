@@ -1,5 +1,9 @@
 ﻿#include "safetyhook/safetyhook.hpp"
 
+#include <array>
+#include <charconv>
+#include <span>
+
 namespace MemoryHelper
 {
 	template <typename T> static bool WriteMemory(uintptr_t address, T value, bool disableProtection = true)
@@ -221,6 +225,62 @@ namespace MemoryHelper
 		int RelativeOffset = ReadMemory<int>(BaseAddress + InstructionOffset);
 		return BaseAddress + InstructionOffset + sizeof(RelativeOffset) + RelativeOffset;
 	}
+
+	// Bump allocator for memory that only lives as long as a hook phase, freed all at once with Release()
+	class BumpArena
+	{
+	public:
+		explicit BumpArena(size_t reserveSize) : reserveSize(reserveSize) {}
+		~BumpArena() { Release(); }
+
+		BumpArena(const BumpArena&) = delete;
+		BumpArena& operator=(const BumpArena&) = delete;
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+		{
+			if (!base)
+			{
+				base = static_cast<uint8_t*>(VirtualAlloc(nullptr, reserveSize, MEM_RESERVE, PAGE_READWRITE));
+				if (!base) return nullptr;
+			}
+
+			size_t offset = (used + alignment - 1) & ~(alignment - 1);
+			if (offset + size > reserveSize) return nullptr;
+
+			// Commit pages as they are reached
+			if (offset + size > committed)
+			{
+				size_t commitEnd = (offset + size + 0xFFF) & ~size_t(0xFFF);
+				if (!VirtualAlloc(base + committed, commitEnd - committed, MEM_COMMIT, PAGE_READWRITE)) return nullptr;
+				committed = commitEnd;
+			}
+
+			used = offset + size;
+			return base + offset;
+		}
+
+		template <typename T> T* AllocateArray(size_t count)
+		{
+			return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+		}
+
+		void Release()
+		{
+			if (base)
+			{
+				VirtualFree(base, 0, MEM_RELEASE);
+				base = nullptr;
+			}
+			used = 0;
+			committed = 0;
+		}
+
+	private:
+		uint8_t* base = nullptr;
+		size_t reserveSize = 0;
+		size_t used = 0;
+		size_t committed = 0;
+	};
 };
 
 namespace HookHelper
@@ -312,12 +372,23 @@ namespace SystemHelper
 		return std::filesystem::path(path).parent_path().string();
 	}
 
-	static DWORD GetCurrentDisplayFrequency()
+	static DWORD GetCurrentDisplayFrequency(HMONITOR monitor = NULL)
 	{
-		DEVMODE devMode = {};
-		devMode.dmSize = sizeof(DEVMODE);
+		// Primary display unless a monitor is given
+		MONITORINFOEXW monitorInfo = {};
+		monitorInfo.cbSize = sizeof(MONITORINFOEXW);
+		const wchar_t* deviceName = nullptr;
 
-		if (EnumDisplaySettings(NULL, ENUM_CURRENT_SETTINGS, &devMode))
+		if (monitor && GetMonitorInfoW(monitor, &monitorInfo))
+		{
+			deviceName = monitorInfo.szDevice;
+		}
+
+		DEVMODEW devMode = {};
+		devMode.dmSize = sizeof(DEVMODEW);
+
+		// 0 and 1 mean the hardware default refresh rate
+		if (EnumDisplaySettingsW(deviceName, ENUM_CURRENT_SETTINGS, &devMode) && devMode.dmDisplayFrequency > 1)
 		{
 			return devMode.dmDisplayFrequency;
 		}
@@ -389,39 +460,194 @@ namespace SystemHelper
 
 namespace IniHelper
 {
-	mINI::INIFile iniFile(SystemHelper::GetModulePath() + "\\MadnessPatch.ini");
-	mINI::INIStructure iniReader;
+	struct IniEntry
+	{
+		std::string_view section;
+		std::string_view key;
+		std::string_view value;
+	};
+
+	static constexpr size_t MAX_INI_ENTRIES = 512;
+
+	std::filesystem::path iniPath = std::filesystem::path(SystemHelper::GetModulePath()) / "MadnessPatch.ini";
+	mINI::INIFile iniFile(iniPath);
+	mINI::INIStructure iniStructure;
+	bool iniStructureLoaded = false;
+
+	// Read path: the file is mapped and parsed in place, entries point into the view
+	HANDLE hIniFile = INVALID_HANDLE_VALUE;
+	HANDLE hIniMapping = NULL;
+	const char* iniView = nullptr;
+	std::array<IniEntry, MAX_INI_ENTRIES> iniEntries;
+	size_t iniEntryCount = 0;
+
+	static std::string_view Trim(std::string_view str)
+	{
+		constexpr std::string_view whitespace = " \t\n\r\f\v";
+		size_t first = str.find_first_not_of(whitespace);
+		if (first == std::string_view::npos)
+			return {};
+		size_t last = str.find_last_not_of(whitespace);
+		return str.substr(first, last - first + 1);
+	}
+
+	template <typename T> static bool ParseNumber(std::string_view str, T& value)
+	{
+		if (!str.empty() && str.front() == '+')
+			str.remove_prefix(1);
+
+		auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+		return ec == std::errc() && ptr != str.data();
+	}
+
+	static void Parse(std::string_view text)
+	{
+		std::string_view section;
+		bool inSection = false;
+		size_t pos = 0;
+
+		while (pos < text.size())
+		{
+			size_t lineEnd = text.find('\n', pos);
+			if (lineEnd == std::string_view::npos)
+				lineEnd = text.size();
+
+			std::string_view line = Trim(text.substr(pos, lineEnd - pos));
+			pos = lineEnd + 1;
+
+			if (line.empty() || line.front() == ';')
+				continue;
+
+			if (line.front() == '[')
+			{
+				// Trailing comments are allowed on section lines
+				std::string_view header = line.substr(0, line.find(';'));
+				size_t closingBracket = header.rfind(']');
+				if (closingBracket != std::string_view::npos)
+				{
+					section = Trim(header.substr(1, closingBracket - 1));
+					inSection = true;
+					continue;
+				}
+			}
+
+			size_t equals = line.find('=');
+			if (!inSection || equals == std::string_view::npos || iniEntryCount == MAX_INI_ENTRIES)
+				continue;
+
+			iniEntries[iniEntryCount++] = { section, Trim(line.substr(0, equals)), Trim(line.substr(equals + 1)) };
+		}
+	}
+
+	std::span<const IniEntry> Entries()
+	{
+		return { iniEntries.data(), iniEntryCount };
+	}
+
+	static const IniEntry* Find(std::string_view sectionName, std::string_view valueName)
+	{
+		// Walk backwards so that duplicated keys resolve to the last one, like mINI does
+		for (size_t i = iniEntryCount; i-- > 0;)
+		{
+			const IniEntry& entry = iniEntries[i];
+			if (entry.key == valueName && entry.section == sectionName)
+				return &entry;
+		}
+		return nullptr;
+	}
+
+	void Close()
+	{
+		iniEntryCount = 0;
+
+		if (iniView)
+		{
+			UnmapViewOfFile(iniView);
+			iniView = nullptr;
+		}
+		if (hIniMapping)
+		{
+			CloseHandle(hIniMapping);
+			hIniMapping = NULL;
+		}
+		if (hIniFile != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(hIniFile);
+			hIniFile = INVALID_HANDLE_VALUE;
+		}
+	}
 
 	void Init()
 	{
-		iniFile.read(iniReader);
+		Close();
+
+		hIniFile = CreateFileW(iniPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hIniFile == INVALID_HANDLE_VALUE)
+			return;
+
+		// Empty files can't be mapped
+		LARGE_INTEGER fileSize = {};
+		if (!GetFileSizeEx(hIniFile, &fileSize) || fileSize.QuadPart == 0)
+		{
+			Close();
+			return;
+		}
+
+		hIniMapping = CreateFileMappingW(hIniFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hIniMapping)
+		{
+			iniView = static_cast<const char*>(MapViewOfFile(hIniMapping, FILE_MAP_READ, 0, 0, 0));
+		}
+
+		if (!iniView)
+		{
+			Close();
+			return;
+		}
+
+		std::string_view text(iniView, static_cast<size_t>(fileSize.QuadPart));
+		if (text.starts_with("\xEF\xBB\xBF"))
+			text.remove_prefix(3);
+
+		Parse(text);
+	}
+
+	// Write path, loaded from disk on first use so lazy writes keep every section
+	mINI::INIStructure& GetStructure()
+	{
+		if (!iniStructureLoaded)
+		{
+			iniFile.read(iniStructure);
+			iniStructureLoaded = true;
+		}
+		return iniStructure;
 	}
 
 	void Save()
 	{
-		iniFile.write(iniReader);
+		// A mapped file can't be truncated, and the parsed spans would be stale after the write anyway
+		Close();
+		iniFile.write(GetStructure());
 	}
 
 	char* ReadString(const char* sectionName, const char* valueName, const char* defaultValue)
 	{
 		char* result = new char[255];
-		try
+
+		if (const IniEntry* entry = Find(sectionName, valueName))
 		{
-			if (iniReader.has(sectionName) && iniReader.get(sectionName).has(valueName))
-			{
-				std::string value = iniReader.get(sectionName).get(valueName);
+			std::string_view value = entry->value;
 
-				if (!value.empty() && (value.front() == '\"' || value.front() == '\''))
-					value.erase(0, 1);
-				if (!value.empty() && (value.back() == '\"' || value.back() == '\''))
-					value.erase(value.size() - 1);
+			if (!value.empty() && (value.front() == '\"' || value.front() == '\''))
+				value.remove_prefix(1);
+			if (!value.empty() && (value.back() == '\"' || value.back() == '\''))
+				value.remove_suffix(1);
 
-				strncpy(result, value.c_str(), 254);
-				result[254] = '\0';
-				return result;
-			}
+			size_t length = (std::min)(value.size(), size_t(254));
+			std::memcpy(result, value.data(), length);
+			result[length] = '\0';
+			return result;
 		}
-		catch (...) {}
 
 		strncpy(result, defaultValue, 254);
 		result[254] = '\0';
@@ -430,31 +656,19 @@ namespace IniHelper
 
 	float ReadFloat(const char* sectionName, const char* valueName, float defaultValue)
 	{
-		try
-		{
-			if (iniReader.has(sectionName) && iniReader.get(sectionName).has(valueName))
-			{
-				const std::string& s = iniReader.get(sectionName).get(valueName);
-				if (!s.empty())
-					return std::stof(s);
-			}
-		}
-		catch (...) {}
+		float value = 0.0f;
+		const IniEntry* entry = Find(sectionName, valueName);
+		if (entry && ParseNumber(entry->value, value))
+			return value;
 		return defaultValue;
 	}
 
 	int ReadInteger(const char* sectionName, const char* valueName, int defaultValue)
 	{
-		try
-		{
-			if (iniReader.has(sectionName) && iniReader.get(sectionName).has(valueName))
-			{
-				const std::string& s = iniReader.get(sectionName).get(valueName);
-				if (!s.empty())
-					return std::stoi(s);
-			}
-		}
-		catch (...) {}
+		int value = 0;
+		const IniEntry* entry = Find(sectionName, valueName);
+		if (entry && ParseNumber(entry->value, value))
+			return value;
 		return defaultValue;
 	}
 };
\ No newline at end of file
@@ -0,0 +1,130 @@
+// Standalone checks for FrameLimiter::FramePacer against a fake clock.
+// Build and run: g++ -std=c++20 -I../src framelimiter_test.cpp -o framelimiter_test && ./framelimiter_test
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include "framelimiter.hpp"
+
+// Microsecond ticks, every sleep overshoots by a fixed amount
+struct FakeClock
+{
+	int64_t now = 1;
+	int64_t overshoot = 300;
+
+	int64_t Now() { return now; }
+	int64_t Frequency() { return 1000000; }
+	void Sleep(int64_t ticks) { now += ticks + overshoot; }
+	void Spin() { now += 1; }
+};
+
+static int g_failures = 0;
+
+static void Check(bool condition, const char* what)
+{
+	if (!condition)
+	{
+		std::printf("FAILED: %s\n", what);
+		g_failures++;
+	}
+}
+
+// Runs frames that take workTicks of game time and counts how many the pacer stretched to its period
+template <typename RateFn> static int CountPacedFrames(int frames, int64_t workTicks, RateFn rate)
+{
+	FakeClock clock;
+	FrameLimiter::FramePacer<FakeClock> pacer(clock);
+
+	int paced = 0;
+	for (int i = 0; i < frames; i++)
+	{
+		const double fps = rate(i);
+		const int64_t start = clock.now;
+		clock.now += workTicks;
+		pacer.Wait(fps);
+
+		// Within a tick or two of the period, the first frame only anchors the cadence
+		const int64_t frameTicks = static_cast<int64_t>(clock.Frequency() / fps);
+		if (i > 0 && std::llabs(clock.now - start - frameTicks) <= 2)
+			paced++;
+	}
+
+	return paced;
+}
+
+static void TestSteadyRate()
+{
+	const int paced = CountPacedFrames(60, 2000, [](int) { return 120.0; });
+	Check(paced == 59, "steady 120 FPS paces every frame after the first");
+}
+
+static void TestDriftingRateKeepsCadence()
+{
+	// The engine reports a slightly different rate every frame
+	const int paced = CountPacedFrames(60, 2000, [](int i) { return i % 2 ? 119.9 : 120.0; });
+	Check(paced == 59, "alternating 120/119.9 FPS keeps pacing every frame");
+}
+
+static void TestRateChangeUsesNewPeriod()
+{
+	FakeClock clock;
+	FrameLimiter::FramePacer<FakeClock> pacer(clock);
+
+	for (int i = 0; i < 10; i++)
+	{
+		clock.now += 2000;
+		pacer.Wait(120.0);
+	}
+
+	const int64_t start = clock.now;
+	clock.now += 2000;
+	pacer.Wait(60.0);
+	Check(std::llabs(clock.now - start - 16666) <= 2, "switching to 60 FPS waits a 60 FPS period from the last boundary");
+}
+
+static void TestFallingBehindRestarts()
+{
+	FakeClock clock;
+	FrameLimiter::FramePacer<FakeClock> pacer(clock);
+
+	clock.now += 2000;
+	pacer.Wait(120.0);
+
+	// A hitch longer than a frame must not be followed by a burst of unpaced frames
+	clock.now += 50000;
+	const int64_t start = clock.now;
+	pacer.Wait(120.0);
+	Check(clock.now == start, "a frame after a long hitch returns at once");
+
+	clock.now += 2000;
+	pacer.Wait(120.0);
+	Check(std::llabs(clock.now - start - 8333) <= 2, "the frame after a hitch is paced from the hitch");
+}
+
+static void TestDisabled()
+{
+	FakeClock clock;
+	FrameLimiter::FramePacer<FakeClock> pacer(clock);
+
+	clock.now += 2000;
+	pacer.Wait(120.0);
+
+	const int64_t start = clock.now;
+	pacer.Wait(0.0);
+	Check(clock.now == start, "a rate of 0 does not wait");
+}
+
+int main()
+{
+	TestSteadyRate();
+	TestDriftingRateKeepsCadence();
+	TestRateChangeUsesNewPeriod();
+	TestFallingBehindRestarts();
+	TestDisabled();
+
+	if (g_failures == 0)
+		std::printf("All frame limiter checks passed\n");
+
+	return g_failures == 0 ? 0 : 1;
+}